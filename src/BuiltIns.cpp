@@ -23,173 +23,600 @@
  */
 #include "BuiltIns.h"
 #include "InterpreterExceptions.h"
-#include "Validator.h"
 #include "bigint/BigIntegerLibrary.h"
 #include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cmath>
 #include <ciso646>
+#include <cstdint>
 #include <iostream>
 #include <string>
 
 using namespace std;
 
-Cells BuiltIns::builtin_cells_;
+namespace {
+/* Divides magnitudes, so that the quotient is truncated toward zero and the
+ * remainder takes the sign of the dividend. b must not be zero. */
+void divide_truncated(const BigInteger& a, const BigInteger& b, BigInteger& quotient,
+                      BigInteger& remainder) {
+  BigUnsigned q, r = a.getMagnitude();
+  r.divideWithRemainder(b.getMagnitude(), q);
+  quotient = BigInteger(move(q), a.getSign() == b.getSign() ? BigInteger::positive
+                                                            : BigInteger::negative);
+  remainder = BigInteger(move(r), a.getSign());
+}
+
+/* The most bits a power or a product of a range may have. Multiplying
+ * numbers that long already takes seconds, so longer ones are refused
+ * rather than left to run out of time or memory; shifts, which take a
+ * single pass, go further. */
+const unsigned long max_result_bits = 1ul << 28;
+
+/* About how many bits base^exponent has: log2 base times the exponent. */
+double power_bits(const BigUnsigned& base, const BigUnsigned& exponent) {
+  auto length = base.bitLength();
+  if (length <= 1) return 0;
+  /* The top 64 bits of the base are plenty for its logarithm. */
+  int dropped = length > 64 ? int(length - 64) : 0;
+  auto e = exponent.bitLength() > 64 ? HUGE_VAL : double(exponent.getBlock(0));
+  return (log2(double((base >> dropped).getBlock(0))) + dropped) * e;
+}
+
+/* Runs f, turning the strings the BigInteger library throws on errors into
+ * errors of the procedure called name. */
+template <class F>
+Value with_big_integers(const string& name, F f) {
+  try {
+    return f();
+  } catch (const char* error) {
+    throw InterpreterException("Error: " + name + " failed: " + error + ".");
+  }
+}
+
+void assert_nonzero_divisor(const string& name, const Value& divisor) {
+  if (divisor.type() == Value::Int and divisor.as_int() == 0) {
+    throw DomainException(name, "a nonzero divisor", "0");
+  }
+}
+
+/* Whether a / b and a % b fit in an int64_t: only INT64_MIN / -1 doesn't. */
+bool divides_natively(const Value& a, const Value& b) {
+  return a.type() == Value::Int and b.type() == Value::Int and
+         not(a.as_int() == INT64_MIN and b.as_int() == -1);
+}
+
+uint64_t magnitude(int64_t i) { return i < 0 ? 0 - uint64_t(i) : uint64_t(i); }
+
+bool is_negative(const Value& i) {
+  return i.type() == Value::Int ? i.as_int() < 0
+                                : i.as_big_integer().getSign() == BigInteger::negative;
+}
+
+/* The product of the count integers from first on, by binary splitting: the
+ * halves of the range are multiplied out separately, so that the work ends
+ * in a few balanced multiplications of big numbers rather than many of a big
+ * number by a small one. Short runs are gathered in a word before touching
+ * BigUnsigned. */
+BigUnsigned multiply_range(const BigUnsigned& first, uint64_t count) {
+  if (count > 16) {
+    auto half = count / 2;
+    return multiply_range(first, half) *
+           multiply_range(first + BigUnsigned((unsigned long)half), count - half);
+  }
 
-const Cells& BuiltIns::get() {
+  BigUnsigned result(1);
+  if (first.getLength() > 1 or first.getBlock(0) > UINT64_MAX - count) {
+    for (uint64_t i = 0; i < count; ++i) result *= first + BigUnsigned((unsigned long)i);
+    return result;
+  }
+  uint64_t word = 1, next;
+  for (uint64_t i = first.getBlock(0), end = i + count; i < end; ++i) {
+    if (__builtin_mul_overflow(word, i, &next)) {
+      result *= BigUnsigned((unsigned long)word);
+      next = i;
+    }
+    word = next;
+  }
+  result *= BigUnsigned((unsigned long)word);
+  return result;
+}
+
+/* The number of integers from first to last, which are all positive or all
+ * negative. Their product has no more bits than they have in all, which
+ * must be at most max_result_bits. */
+uint64_t range_length(const string& name, const BigInteger& first, const BigInteger& last) {
+  if (first > last) return 0;
+  auto low = first.getMagnitude(), high = last.getMagnitude();
+  if (first.getSign() == BigInteger::negative) swap(low, high);
+
+  /* Add up the bits of the integers of each length in turn. */
+  BigUnsigned bits(0), limit(max_result_bits);
+  for (auto length = low.bitLength(); length <= high.bitLength() and bits <= limit; ++length) {
+    auto start = max(low, BigUnsigned(1) << int(length - 1));
+    auto end = min(high, (BigUnsigned(1) << int(length)) - BigUnsigned(1));
+    bits += (end - start + BigUnsigned(1)) * BigUnsigned((unsigned long)length);
+  }
+  if (bits > limit) {
+    throw DomainException(name, "a range of integers of at most 2^28 bits in all",
+                          bigIntegerToString(first) + " to " + bigIntegerToString(last));
+  }
+  return (high - low).getBlock(0) + 1;
+}
+
+/* A negative x is ~m in two's complement, for m = |x| - 1: the bitwise
+ * operations work on m and say whether the result is complemented too. */
+BigUnsigned complement_magnitude(const BigInteger& x) {
+  if (x.getSign() != BigInteger::negative) return x.getMagnitude();
+  return x.getMagnitude() - BigUnsigned(1);
+}
+
+Value from_complement(BigUnsigned m, bool complemented) {
+  if (not complemented) return Value::integer(BigInteger(move(m)));
+  return Value::integer(BigInteger(m + BigUnsigned(1), BigInteger::negative));
+}
+
+/* The shift amount, which must be nonnegative. Amounts that don't fit in an
+ * int come back as INT_MAX. */
+int shift_amount(const string& name, const Value& amount) {
+  if (is_negative(amount)) {
+    throw DomainException(name, "a nonnegative shift", amount.to_string());
+  }
+  if (amount.type() == Value::Int and amount.as_int() < INT_MAX) return int(amount.as_int());
+  return INT_MAX;
+}
+
+/* The more precise of two types the elements of one list were given at run
+ * time. They only differ where one has the type of empty and the other
+ * knows the type of the elements; null stands for unknown as well. */
+const LiteralType* merge_types(const LiteralType* a, const LiteralType* b) {
+  if (a == b or not b) return a;
+  if (not a) return b;
+  if (b == LiteralType::empty()) return a;
+  if (a == LiteralType::empty()) return b;
+  if (a->kind() == LiteralType::List and b->kind() == LiteralType::List) {
+    return LiteralType::list(merge_types(a->element(), b->element()));
+  }
+  return a;
+}
+} // namespace
+
+Bindings BuiltIns::builtins_;
+
+const Bindings& BuiltIns::get() {
   static bool initialized = false;
   if (not initialized) {
     initialize();
     initialized = true;
   }
-  return builtin_cells_;
+  return builtins_;
 }
 
 void BuiltIns::initialize() {
-  builtin_cells_.emplace_back(BuiltIns::sum, "+", "int,int->int");
-  builtin_cells_.emplace_back(BuiltIns::difference, "-", "int,int->int");
-  builtin_cells_.emplace_back(BuiltIns::multiplication, "*", "int,int->int");
-  builtin_cells_.emplace_back(BuiltIns::less_than, "<", "int,int->bool");
-  builtin_cells_.emplace_back(BuiltIns::logic_not, "not", "bool->bool");
-  builtin_cells_.emplace_back(BuiltIns::logic_and, "and", "bool,bool->bool");
-  builtin_cells_.emplace_back(BuiltIns::empty_test, "empty?", "x->bool");
-  builtin_cells_.emplace_back(BuiltIns::first, "first", "[x]->x");
-  builtin_cells_.emplace_back(BuiltIns::rest, "rest", "[x]->[x]");
-  builtin_cells_.emplace_back(BuiltIns::cons, "cons", "x,[x]->[x]");
-  builtin_cells_.emplace_back(BuiltIns::list, "list", "x,x,...,x->[x]");
-  builtin_cells_.emplace_back(Cell::empty_cell());
-  builtin_cells_.emplace_back(Cell::true_cell());
-  builtin_cells_.emplace_back(Cell::false_cell());
+  auto add = [](const string& name, BuiltinProcedure procedure, const string& literal_type) {
+    builtins_.emplace_back(name,
+                           Value::builtin(move(procedure), name, LiteralType::parse(literal_type)));
+  };
+
+  add("+", BuiltIns::sum, "int,int->int");
+  add("-", BuiltIns::difference, "int,int->int");
+  add("*", BuiltIns::multiplication, "int,int->int");
+  add("<", BuiltIns::less_than, "int,int->bool");
+  add("quotient", BuiltIns::quotient, "int,int->int");
+  add("remainder", BuiltIns::remainder, "int,int->int");
+  add("modulo", BuiltIns::modulo, "int,int->int");
+  add("gcd", BuiltIns::gcd, "int,int->int");
+  add("expt", BuiltIns::expt, "int,int->int");
+  add("modexp", BuiltIns::modexp, "int,int,int->int");
+  add("factorial", BuiltIns::factorial, "int->int");
+  add("binomial", BuiltIns::binomial, "int,int->int");
+  add("product-range", BuiltIns::product_range, "int,int->int");
+  add("bit-and", BuiltIns::bit_and, "int,int->int");
+  add("bit-or", BuiltIns::bit_or, "int,int->int");
+  add("bit-xor", BuiltIns::bit_xor, "int,int->int");
+  add("shift-left", BuiltIns::shift_left, "int,int->int");
+  add("shift-right", BuiltIns::shift_right, "int,int->int");
+  add("bit-length", BuiltIns::bit_length, "int->int");
+  add("isqrt", BuiltIns::isqrt, "int->int");
+  add("ilog2", BuiltIns::ilog2, "int->int");
+  add("not", BuiltIns::logic_not, "bool->bool");
+  add("and", BuiltIns::logic_and, "bool,bool->bool");
+  add("empty?", BuiltIns::empty_test, "x->bool");
+  add("first", BuiltIns::first, "[x]->x");
+  add("rest", BuiltIns::rest, "[x]->[x]");
+  add("cons", BuiltIns::cons, "x,[x]->[x]");
+  add("list", BuiltIns::list, "x,x,...,x->[x]");
+  builtins_.emplace_back("empty", Value());
+  builtins_.emplace_back("true", Value::boolean(true));
+  builtins_.emplace_back("false", Value::boolean(false));
 }
 
-Cell BuiltIns::sum(const Cells& args) {
-  Validator::assert_arity("+", 2, args);
-  Validator::assert_type("+", "int", args[0]);
-  Validator::assert_type("+", "int", args[1]);
+Value BuiltIns::sum(const Values& args) {
+  int64_t result;
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int and
+      not __builtin_add_overflow(args[0].as_int(), args[1].as_int(), &result)) {
+    return Value::integer(result);
+  }
 
-  auto first = stringToBigInteger(args[0].value());
-  auto second = stringToBigInteger(args[1].value());
+  auto first = args[0].as_big_integer();
+  first += args[1].as_big_integer();
 
-  first += second;
+  return Value::integer(move(first));
+}
 
-  return Cell(Cell::Literal, bigIntegerToString(first), "int");
+Value BuiltIns::difference(const Values& args) {
+  int64_t result;
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int and
+      not __builtin_sub_overflow(args[0].as_int(), args[1].as_int(), &result)) {
+    return Value::integer(result);
+  }
+
+  auto first = args[0].as_big_integer();
+  first -= args[1].as_big_integer();
+
+  return Value::integer(move(first));
+}
+
+Value BuiltIns::multiplication(const Values& args) {
+  int64_t result;
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int and
+      not __builtin_mul_overflow(args[0].as_int(), args[1].as_int(), &result)) {
+    return Value::integer(result);
+  }
+
+  auto first = args[0].as_big_integer();
+  first *= args[1].as_big_integer();
+
+  return Value::integer(move(first));
+}
+
+Value BuiltIns::less_than(const Values& args) {
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int) {
+    return Value::boolean(args[0].as_int() < args[1].as_int());
+  }
+
+  return Value::boolean(args[0].as_big_integer() < args[1].as_big_integer());
 }
 
-Cell BuiltIns::difference(const Cells& args) {
-  Validator::assert_arity("-", 2, args);
-  Validator::assert_type("-", "int", args[0]);
-  Validator::assert_type("-", "int", args[1]);
+Value BuiltIns::quotient(const Values& args) {
+  assert_nonzero_divisor("quotient", args[1]);
+  if (divides_natively(args[0], args[1])) {
+    return Value::integer(args[0].as_int() / args[1].as_int());
+  }
 
-  auto first = stringToBigInteger(args[0].value());
-  auto second = stringToBigInteger(args[1].value());
+  return with_big_integers("quotient", [&] {
+    BigInteger quotient, remainder;
+    divide_truncated(args[0].as_big_integer(), args[1].as_big_integer(), quotient, remainder);
+    return Value::integer(move(quotient));
+  });
+}
 
-  first -= second;
+Value BuiltIns::remainder(const Values& args) {
+  assert_nonzero_divisor("remainder", args[1]);
+  if (divides_natively(args[0], args[1])) {
+    return Value::integer(args[0].as_int() % args[1].as_int());
+  }
 
-  return Cell(Cell::Literal, bigIntegerToString(first), "int");
+  return with_big_integers("remainder", [&] {
+    BigInteger quotient, remainder;
+    divide_truncated(args[0].as_big_integer(), args[1].as_big_integer(), quotient, remainder);
+    return Value::integer(move(remainder));
+  });
 }
 
-Cell BuiltIns::multiplication(const Cells& args) {
-  Validator::assert_arity("*", 2, args);
-  Validator::assert_type("*", "int", args[0]);
-  Validator::assert_type("*", "int", args[1]);
+Value BuiltIns::modulo(const Values& args) {
+  assert_nonzero_divisor("modulo", args[1]);
+  if (divides_natively(args[0], args[1])) {
+    auto a = args[0].as_int(), b = args[1].as_int();
+    auto r = a % b;
+    /* r + b can't overflow, since r and b have opposite signs. */
+    return Value::integer(r != 0 and (r < 0) != (b < 0) ? r + b : r);
+  }
 
-  auto first = stringToBigInteger(args[0].value());
-  auto second = stringToBigInteger(args[1].value());
+  return with_big_integers("modulo", [&] {
+    auto b = args[1].as_big_integer();
+    BigInteger quotient, remainder;
+    divide_truncated(args[0].as_big_integer(), b, quotient, remainder);
+    if (not remainder.isZero() and remainder.getSign() != b.getSign()) remainder += b;
+    return Value::integer(move(remainder));
+  });
+}
 
-  first *= second;
+Value BuiltIns::gcd(const Values& args) {
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int) {
+    auto a = magnitude(args[0].as_int()), b = magnitude(args[1].as_int());
+    while (b != 0) {
+      auto r = a % b;
+      a = b;
+      b = r;
+    }
+    /* gcd(INT64_MIN, INT64_MIN) is 2^63, one past INT64_MAX. */
+    return Value::integer(BigInteger(BigUnsigned(a)));
+  }
 
-  return Cell(Cell::Literal, bigIntegerToString(first), "int");
+  return with_big_integers("gcd", [&] {
+    return Value::integer(BigInteger(::gcd(args[0].as_big_integer().getMagnitude(),
+                                           args[1].as_big_integer().getMagnitude())));
+  });
 }
 
-Cell BuiltIns::less_than(const Cells& args) {
+Value BuiltIns::expt(const Values& args) {
+  if (is_negative(args[1])) {
+    throw DomainException("expt", "a nonnegative exponent", args[1].to_string());
+  }
 
-  Validator::assert_arity("<", 2, args);
-  Validator::assert_type("<", "int", args[0]);
-  Validator::assert_type("<", "int", args[1]);
+  /* Square-and-multiply, first in int64_t until something overflows. */
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int) {
+    auto base = args[0].as_int(), result = int64_t(1);
+    auto exponent = uint64_t(args[1].as_int());
+    bool overflow = false;
+    while (exponent != 0 and not overflow) {
+      if (exponent & 1) overflow = __builtin_mul_overflow(result, base, &result);
+      exponent >>= 1;
+      if (exponent != 0 and not overflow) overflow = __builtin_mul_overflow(base, base, &base);
+    }
+    if (not overflow) return Value::integer(result);
+  }
 
-  auto first = stringToBigInteger(args[0].value());
-  auto second = stringToBigInteger(args[1].value());
+  auto base = args[0].as_big_integer();
+  auto exponent = args[1].as_big_integer().getMagnitude();
+  if (power_bits(base.getMagnitude(), exponent) >= double(max_result_bits)) {
+    throw DomainException("expt", "a result of at most 2^28 bits",
+                          args[0].to_string() + " to the " + args[1].to_string());
+  }
 
-  return (first < second) ? Cell::true_cell() : Cell::false_cell();
+  /* From the top bit of the exponent down, so that the multiplications
+   * by the base stay small. */
+  return with_big_integers("expt", [&] {
+    BigInteger result(1);
+    for (auto i = exponent.bitLength(); i-- > 0;) {
+      result *= result;
+      if (exponent.getBit(i)) result *= base;
+    }
+    return Value::integer(move(result));
+  });
 }
 
-Cell BuiltIns::logic_not(const Cells& args) {
+Value BuiltIns::modexp(const Values& args) {
+  if (is_negative(args[1])) {
+    throw DomainException("modexp", "a nonnegative exponent", args[1].to_string());
+  }
+  if (is_negative(args[2]) or (args[2].type() == Value::Int and args[2].as_int() == 0)) {
+    throw DomainException("modexp", "a positive modulus", args[2].to_string());
+  }
 
-  Validator::assert_arity("not", 1, args);
-  Validator::assert_type("not", "bool", args[0]);
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int and
+      args[2].type() == Value::Int) {
+    auto modulus = uint64_t(args[2].as_int());
+    auto base = args[0].as_int() % int64_t(modulus);
+    auto b = uint64_t(base < 0 ? base + int64_t(modulus) : base);
+    auto result = uint64_t(1) % modulus;
+    for (auto exponent = uint64_t(args[1].as_int()); exponent != 0; exponent >>= 1) {
+      if (exponent & 1) result = uint64_t((unsigned __int128)result * b % modulus);
+      b = uint64_t((unsigned __int128)b * b % modulus);
+    }
+    return Value::integer(int64_t(result));
+  }
 
-  return (args[0].value() == "true") ? Cell::false_cell() : Cell::true_cell();
+  return with_big_integers("modexp", [&] {
+    return Value::integer(BigInteger(::modexp(args[0].as_big_integer(),
+                                              args[1].as_big_integer().getMagnitude(),
+                                              args[2].as_big_integer().getMagnitude())));
+  });
 }
 
-Cell BuiltIns::logic_and(const Cells& args) {
+Value BuiltIns::factorial(const Values& args) {
+  if (is_negative(args[0])) {
+    throw DomainException("factorial", "a nonnegative integer", args[0].to_string());
+  }
 
-  Validator::assert_arity("and", 2, args);
-  Validator::assert_type("and", "bool", args[0]);
-  Validator::assert_type("and", "bool", args[1]);
+  auto n = args[0].as_big_integer();
+  auto count = range_length("factorial", 1, n);
+  return with_big_integers("factorial", [&] {
+    return Value::integer(BigInteger(multiply_range(BigUnsigned(1), count)));
+  });
+}
 
-  return (args[0].value() == "true" and args[1].value() == "true") ? Cell::true_cell()
-                                                                   : Cell::false_cell();
+Value BuiltIns::binomial(const Values& args) {
+  if (is_negative(args[0])) {
+    throw DomainException("binomial", "a nonnegative integer", args[0].to_string());
+  }
+
+  auto n = args[0].as_big_integer(), k = args[1].as_big_integer();
+  if (k.getSign() == BigInteger::negative or k > n) return Value::integer(0);
+  if (n - k < k) k = n - k;
+
+  /* n (n - 1) ... (n - k + 1) / k!, both by binary splitting. */
+  auto count = range_length("binomial", n - k + BigInteger(1), n);
+  return with_big_integers("binomial", [&] {
+    auto numerator = multiply_range((n - k + BigInteger(1)).getMagnitude(), count);
+    BigUnsigned quotient;
+    numerator.divideWithRemainder(multiply_range(BigUnsigned(1), count), quotient);
+    return Value::integer(BigInteger(move(quotient)));
+  });
 }
 
-Cell BuiltIns::empty_test(const Cells& args) {
+Value BuiltIns::product_range(const Values& args) {
+  auto first = args[0].as_big_integer(), last = args[1].as_big_integer();
+  if (first > last) return Value::integer(1);
+  if (first.getSign() != BigInteger::positive and last.getSign() != BigInteger::negative) {
+    return Value::integer(0);
+  }
 
-  Validator::assert_arity("empty?", 1, args);
+  auto count = range_length("product-range", first, last);
+  return with_big_integers("product-range", [&] {
+    if (first.getSign() == BigInteger::positive) {
+      return Value::integer(BigInteger(multiply_range(first.getMagnitude(), count)));
+    }
+    /* An all-negative range: multiply the magnitudes from the smallest up. */
+    return Value::integer(BigInteger(multiply_range(last.getMagnitude(), count),
+                                     count % 2 == 1 ? BigInteger::negative
+                                                    : BigInteger::positive));
+  });
+}
+
+Value BuiltIns::bit_and(const Values& args) {
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int) {
+    return Value::integer(args[0].as_int() & args[1].as_int());
+  }
 
-  return args[0].is_empty() ? Cell::true_cell() : Cell::false_cell();
+  return with_big_integers("bit-and", [&] {
+    auto a = args[0].as_big_integer(), b = args[1].as_big_integer();
+    bool na = a.getSign() == BigInteger::negative, nb = b.getSign() == BigInteger::negative;
+    auto ma = complement_magnitude(a), mb = complement_magnitude(b);
+    if (na and nb) return from_complement(ma | mb, true);
+    if (na) return from_complement(mb - (mb & ma), false);
+    if (nb) return from_complement(ma - (ma & mb), false);
+    return from_complement(ma & mb, false);
+  });
 }
 
-Cell BuiltIns::first(const Cells& args) {
+Value BuiltIns::bit_or(const Values& args) {
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int) {
+    return Value::integer(args[0].as_int() | args[1].as_int());
+  }
 
-  Validator::assert_arity("first", 1, args);
+  return with_big_integers("bit-or", [&] {
+    auto a = args[0].as_big_integer(), b = args[1].as_big_integer();
+    bool na = a.getSign() == BigInteger::negative, nb = b.getSign() == BigInteger::negative;
+    auto ma = complement_magnitude(a), mb = complement_magnitude(b);
+    if (na and nb) return from_complement(ma & mb, true);
+    if (na) return from_complement(ma - (ma & mb), true);
+    if (nb) return from_complement(mb - (mb & ma), true);
+    return from_complement(ma | mb, false);
+  });
+}
 
-  if (args[0].is_empty()) return Cell::empty_cell();
+Value BuiltIns::bit_xor(const Values& args) {
+  if (args[0].type() == Value::Int and args[1].type() == Value::Int) {
+    return Value::integer(args[0].as_int() ^ args[1].as_int());
+  }
 
-  if (args[0].type() != Cell::List)
-    throw InterpreterException("Error: argument to first must be a list.");
+  return with_big_integers("bit-xor", [&] {
+    auto a = args[0].as_big_integer(), b = args[1].as_big_integer();
+    bool na = a.getSign() == BigInteger::negative, nb = b.getSign() == BigInteger::negative;
+    return from_complement(complement_magnitude(a) ^ complement_magnitude(b), na != nb);
+  });
+}
 
-  return args[0].arg(0);
+Value BuiltIns::shift_left(const Values& args) {
+  auto amount = shift_amount("shift-left", args[1]);
+  if (args[0].type() == Value::Int) {
+    auto i = args[0].as_int();
+    if (i == 0) return Value::integer(0);
+    if (amount < 63) {
+      auto shifted = int64_t(uint64_t(i) << amount);
+      if (shifted >> amount == i) return Value::integer(shifted);
+    }
+  }
+
+  if (amount == INT_MAX) {
+    throw DomainException("shift-left", "a shift below 2^31 - 1", args[1].to_string());
+  }
+  return with_big_integers("shift-left", [&] {
+    auto i = args[0].as_big_integer();
+    return Value::integer(BigInteger(i.getMagnitude() << amount, i.getSign()));
+  });
 }
 
-Cell BuiltIns::rest(const Cells& args) {
+Value BuiltIns::shift_right(const Values& args) {
+  auto amount = shift_amount("shift-right", args[1]);
+  if (args[0].type() == Value::Int) {
+    return Value::integer(args[0].as_int() >> min(amount, 63));
+  }
 
-  Validator::assert_arity("rest", 1, args);
+  return with_big_integers("shift-right", [&] {
+    auto i = args[0].as_big_integer();
+    bool negative = i.getSign() == BigInteger::negative;
+    auto m = complement_magnitude(i);
+    if (BigUnsigned::Index(amount) >= m.bitLength()) return Value::integer(negative ? -1 : 0);
+    return from_complement(m >> amount, negative);
+  });
+}
+
+Value BuiltIns::bit_length(const Values& args) {
+  if (args[0].type() == Value::Int) {
+    auto i = args[0].as_int();
+    auto bits = uint64_t(i < 0 ? ~i : i);
+    return Value::integer(bits == 0 ? 0 : 64 - __builtin_clzll(bits));
+  }
 
-  if (args[0].arity() < 2) return Cell::empty_cell();
+  return Value::integer(int64_t(complement_magnitude(args[0].as_big_integer()).bitLength()));
+}
 
-  Cell c(args[0]);
-  c.pop_first_arg();
+Value BuiltIns::isqrt(const Values& args) {
+  if (is_negative(args[0])) {
+    throw DomainException("isqrt", "a nonnegative integer", args[0].to_string());
+  }
 
-  return c;
+  if (args[0].type() == Value::Int) {
+    /* The double is within one of the root; step onto it exactly. */
+    auto n = uint64_t(args[0].as_int());
+    auto r = uint64_t(sqrt(double(n)));
+    while ((unsigned __int128)r * r > n) --r;
+    while ((unsigned __int128)(r + 1) * (r + 1) <= n) ++r;
+    return Value::integer(int64_t(r));
+  }
+
+  return with_big_integers("isqrt", [&] {
+    return Value::integer(BigInteger(::isqrt(args[0].as_big_integer().getMagnitude())));
+  });
 }
 
-Cell BuiltIns::cons(const Cells& args) {
-  Validator::assert_arity("cons", 2, args);
+Value BuiltIns::ilog2(const Values& args) {
+  if (is_negative(args[0]) or (args[0].type() == Value::Int and args[0].as_int() == 0)) {
+    throw DomainException("ilog2", "a positive integer", args[0].to_string());
+  }
+
+  if (args[0].type() == Value::Int) {
+    return Value::integer(63 - __builtin_clzll(uint64_t(args[0].as_int())));
+  }
+  return Value::integer(int64_t(args[0].as_big_integer().getMagnitude().bitLength() - 1));
+}
 
-  Cell c(Cell::List);
-  c.add_arg(args[0]);
+Value BuiltIns::logic_not(const Values& args) {
+  return Value::boolean(not args[0].as_bool());
+}
 
-  if (not args[1].is_empty()) {
+Value BuiltIns::logic_and(const Values& args) {
+  return Value::boolean(args[0].as_bool() and args[1].as_bool());
+}
 
-    Validator::assert_list_type(args[0], args[1].args());
+Value BuiltIns::empty_test(const Values& args) {
+  return Value::boolean(args[0].is_empty());
+}
 
-    if (args[1].type() == Cell::List) {
-      for (const auto& a : args[1].args())
-        c.add_arg(a);
-    }
+Value BuiltIns::first(const Values& args) {
+  /* The checker can't tell an empty list from others, so this is the one
+   * list error left for run time. */
+  if (args[0].is_empty()) {
+    throw InterpreterException("Error: first expects a nonempty list, given empty.");
   }
 
-  c.set_literal_type("[" + args[0].literal_type() + "]");
-  return c;
+  return args[0].first();
 }
 
-Cell BuiltIns::list(const Cells& args) {
+Value BuiltIns::rest(const Values& args) {
+  if (args[0].is_empty()) {
+    throw InterpreterException("Error: rest expects a nonempty list, given empty.");
+  }
 
-  if (args.size() == 0) return Cell::empty_cell();
+  return args[0].rest();
+}
 
-  Validator::assert_list_type(args[0], args);
+Value BuiltIns::cons(const Values& args) {
+  /* The tail already knows the type of the list, unless it's empty or
+   * the head is more precise, as (list 1) is next to empty. */
+  const auto* type = args[1].literal_type();
+  const auto* element = merge_types(args[0].literal_type(), type->element());
+  if (element != type->element()) type = LiteralType::list(element);
+  return Value::cons(args[0], args[1], type);
+}
 
-  Cell c(Cell::List);
-  c.set_args(args);
-  c.set_literal_type("[" + args[0].literal_type() + "]");
+Value BuiltIns::list(const Values& args) {
+  if (args.size() == 0) return Value();
 
-  return c;
+  const LiteralType* element = nullptr;
+  for (const auto& a : args) element = merge_types(element, a.literal_type());
+  return Value::list(args, LiteralType::list(element));
 }
@@ -24,37 +24,88 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
-#include "Cell.h"
+#include "Value.h"
 
+typedef std::vector<std::pair<std::string, Value>> Bindings;
+
+/* The procedures bound in the global context. Each is given a type, which
+ * the TypeChecker holds calls to; the procedures themselves trust it and
+ * don't check the types of their arguments. They only reject values their
+ * type allows but they can't take, such as a zero divisor, with a
+ * DomainException. */
 class BuiltIns {	
 public:
-	static const Cells& get();;
+	static const Bindings& get();
 
 private:
-	static Cell sum(const Cells& args);	
+	static Value sum(const Values& args);	
+
+	static Value difference(const Values& args);
+
+	static Value multiplication(const Values& args);
+
+	static Value less_than(const Values& args);
+
+	/* quotient truncates toward zero, so remainder takes the sign of the
+	 * dividend; modulo takes the sign of the divisor. */
+	static Value quotient(const Values& args);
+
+	static Value remainder(const Values& args);
+
+	static Value modulo(const Values& args);
+
+	static Value gcd(const Values& args);
+
+	static Value expt(const Values& args);
+
+	static Value modexp(const Values& args);
+
+	static Value factorial(const Values& args);
+
+	static Value binomial(const Values& args);
+
+	/* The product of the integers from the first argument to the second,
+	 * inclusive; 1 if the range is empty. */
+	static Value product_range(const Values& args);
+
+	/* The bitwise operations see a negative integer in two's complement,
+	 * as if it had infinitely many leading ones; shift-right floors. */
+	static Value bit_and(const Values& args);
+
+	static Value bit_or(const Values& args);
+
+	static Value bit_xor(const Values& args);
+
+	static Value shift_left(const Values& args);
+
+	static Value shift_right(const Values& args);
 
-	static Cell difference(const Cells& args);
+	/* The number of bits of the two's complement, less the sign bit: that of
+	 * x for x >= 0 and of -x - 1 otherwise. */
+	static Value bit_length(const Values& args);
 
-	static Cell multiplication(const Cells& args);
+	static Value isqrt(const Values& args);
 
-	static Cell less_than(const Cells& args);
+	static Value ilog2(const Values& args);
 
-	static Cell logic_not(const Cells& args);
+	static Value logic_not(const Values& args);
 
-	static Cell logic_and(const Cells& args);
+	static Value logic_and(const Values& args);
 
-	static Cell empty_test(const Cells& args);
+	static Value empty_test(const Values& args);
 
-	static Cell first(const Cells& args);
+	static Value first(const Values& args);
 
-	static Cell rest(const Cells& args);
+	static Value rest(const Values& args);
 
-	static Cell cons(const Cells& args);	
+	static Value cons(const Values& args);	
 
-	static Cell list(const Cells& args);
+	static Value list(const Values& args);
 
 	static void initialize();
 
-	static Cells builtin_cells_;
+	static Bindings builtins_;
 };
\ No newline at end of file
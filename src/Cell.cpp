@@ -23,43 +23,38 @@
  */
 #include "Cell.h"
 #include "Parser.h"
-#include <boost/regex.hpp>
 #include <cassert>
 #include <ciso646>
 #include <iostream>
 
 using namespace std;
 
+#ifndef NDEBUG
+long Cell::copies_ = 0;
+#endif
+
 Cell::Cell() { type_ = Type::Empty; }
 
 Cell::Cell(const Cell& cell)
-    : value_(cell.value_), args_(cell.args_), procedure_(cell.procedure_),
-      literal_type_(cell.literal_type_), context_(cell.context_), type_(cell.type_) {}
-
-Cell::Cell(BuiltinProcedure proc, const string& value, const string& literal_type)
-    : value_(value), type_(BuiltInProcedure), literal_type_(literal_type),
-      procedure_(proc) {}
-
-Cell::Cell(Type type, const string& value, const std::string& literal_type)
-    : type_(type), value_(value), literal_type_(literal_type) {}
-
-const Cell& Cell::true_cell() {
-  static Cell c(Literal, "true");
-  c.set_literal_type("bool");
-  return c;
+    : value_(cell.value_), args_(cell.args_), literal_type_(cell.literal_type_),
+      symbol_(cell.symbol_), location_(cell.location_), index_(cell.index_),
+      boxed_(cell.boxed_), frame_size_(cell.frame_size_), boxes_(cell.boxes_),
+      captures_(cell.captures_), type_(cell.type_) {
+#ifndef NDEBUG
+  ++copies_;
+#endif
 }
 
-const Cell& Cell::false_cell() {
-  static Cell c(Literal, "false");
-  c.set_literal_type("bool");
-  return c;
+Cell& Cell::operator=(const Cell& cell) {
+  if (this != &cell) {
+    Cell copy(cell);
+    *this = move(copy);
+  }
+  return *this;
 }
 
-const Cell& Cell::empty_cell() {
-  static Cell c(Empty, "empty");
-  c.set_literal_type("[]");
-  return c;
-}
+Cell::Cell(Type type, const string& value, const LiteralType* literal_type)
+    : type_(type), value_(value), literal_type_(literal_type) {}
 
 string Cell::to_string() const {
   if (is_value()) {
@@ -77,18 +72,3 @@ string Cell::to_string() const {
 void Cell::pop_first_arg() {
   if (arity() >= 1) args_.erase(args_.begin());
 }
-
-std::string Cell::return_type() const {
-  boost::smatch sm;
-  static const boost::regex parse_type(".*->(.*)");
-  if (boost::regex_match(literal_type_, sm, parse_type)) {
-    return sm[1].str();
-  } else {
-    return literal_type_;
-  }
-}
-
-bool Cell::is_literal_list() const {
-  return literal_type_.size() >= 2 and literal_type_.front() == '[' and
-         literal_type_.back() == ']';
-}
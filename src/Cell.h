@@ -26,15 +26,12 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <functional>
-
-class Context;
+#include "LiteralType.h"
 
 class Cell {	
 public:
 	enum Type {
 		Lambda,
-		BuiltInProcedure,
 		Literal,
 		Symbol,
 		List,
@@ -44,18 +41,21 @@ public:
  	Cell();
 
 	Cell(Type type, const std::string& value = "", 
-		const std::string& literal_type = "");
-
-	Cell(std::function<Cell(const std::vector<Cell>&)> proc, 
-		const std::string& value = "", const std::string& literal_type = "");
+		const LiteralType* literal_type = nullptr);
 
+ 	/* Copies the whole subtree. Evaluation never should, so debug builds
+ 	 * count copies for CommandLine to check. */
  	Cell(const Cell& cell);
 
-	static const Cell& true_cell();
+	Cell(Cell&& cell) = default;
 
-	static const Cell& false_cell();
+	Cell& operator=(const Cell& cell);
 
-	static const Cell& empty_cell();
+	Cell& operator=(Cell&& cell) = default;
+
+#ifndef NDEBUG
+	static long copies() { return copies_; }
+#endif
 
 	std::string to_string() const;
 
@@ -65,8 +65,6 @@ public:
 
 	bool is_empty() const { return type() == Empty; }
 
-	bool is_literal_list() const;
-
 	bool is_literal() const { return type() == Literal;  }
 
 	void pop_first_arg();
@@ -95,36 +93,97 @@ public:
 
 	void set_type(Type type) { type_ = type; }
 
-	const std::string& literal_type() const { return literal_type_; }
+	/* Set on literals and, once parsed, on lambdas and their parameters. */
+	const LiteralType* literal_type() const { return literal_type_; }
 
-	std::string return_type() const;
-
-	void set_literal_type(const std::string& literal_type) {
+	void set_literal_type(const LiteralType* literal_type) {
 		literal_type_ = literal_type;
 	}
 
-	std::function<Cell(const std::vector<Cell>&)> 
-		procedure() const { return procedure_; }
+	int symbol() const { return symbol_; }
+
+	void set_symbol(int symbol) { symbol_ = symbol; }
+
+	/* Where a variable lives, filled in by the Resolver. A lambda's frame
+	 * holds its parameters and then every name defined in its body, those
+	 * of its local blocks included. The variables it uses from enclosing
+	 * frames are copied into the closure when the lambda is evaluated, and
+	 * read from there by index. Globals are looked up by symbol id. */
+	enum Location { Global, Slot, Captured };
+
+	/* Where one of a lambda's captures is found in the frame the lambda is
+	 * evaluated in: one of its Slots, or one of its own Captured values. */
+	struct Capture {
+		Location location;
+
+		int index;
+	};
+
+	bool is_global() const { return location_ == Global; }
+
+	Location location() const { return location_; }
+
+	/* The slot or capture index of a variable. */
+	int index() const { return index_; }
+
+	void set_location(Location location, int index) { 
+		location_ = location; 
+		index_ = index; 
+	}
 
-	std::shared_ptr<Context> context() const { return context_; }
+	/* Set on the uses of a variable that is both captured and defined: its
+	 * slot holds a Box, so that closures made before the definition see
+	 * it. */
+	bool is_boxed() const { return boxed_; }
 
-	void set_context(std::shared_ptr<Context> context) { context_ = context; }
+	void set_boxed(bool boxed) { boxed_ = boxed; }
+
+	/* Number of slots in the frame opened by a lambda, or by a local block
+	 * outside of any lambda. Other local blocks keep their names in the
+	 * frame of the lambda around them, and open none. */
+	int frame_size() const { return frame_size_; }
+
+	void set_frame_size(int frame_size) { frame_size_ = frame_size; }
+
+	/* The slots of that frame holding a Box. */
+	const std::vector<int>& boxes() const { return boxes_; }
+
+	void set_boxes(std::vector<int> boxes) { boxes_ = std::move(boxes); }
+
+	const std::vector<Capture>& captures() const { return captures_; }
+
+	void set_captures(std::vector<Capture> captures) { 
+		captures_ = std::move(captures); 
+	}
 
 
 private:
 	std::string value_;
 
 	std::vector<Cell> args_;	
-	
-	std::function<Cell(const std::vector<Cell>&)> procedure_;
 
-	std::string literal_type_;	
+	const LiteralType* literal_type_ = nullptr;
 
-	std::shared_ptr<Context> context_;
+	int symbol_ = -1;
+
+	Location location_ = Global;
+
+	int index_ = -1;
+
+	bool boxed_ = false;
+
+	int frame_size_ = 0;
+
+	std::vector<int> boxes_;
+
+	std::vector<Capture> captures_;
 
 
 	Type type_;
+
+#ifndef NDEBUG
+	static long copies_;
+#endif
 };
 
-typedef std::vector<Cell> Cells;
-typedef std::function<Cell(const Cells&)> BuiltinProcedure;
\ No newline at end of file
+typedef std::vector<Cell> Cells;
\ No newline at end of file
@@ -0,0 +1,438 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "ClosureCompiler.h"
+#include "Cell.h"
+#include "Context.h"
+#include "Function.h"
+#include "InterpreterExceptions.h"
+#include "SymbolTable.h"
+
+#include <ciso646>
+#include <iterator>
+#include <vector>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+using namespace std;
+
+namespace {
+typedef unique_ptr<const Node> NodePointer;
+
+typedef vector<NodePointer> NodePointers;
+
+/* Applies a built-in to the argc values on top of the stack. */
+Value apply_builtin(Activation& a, const Value& procedure, size_t argc) {
+	auto& stack = *a.stack;
+	auto& arguments = *a.arguments;
+	arguments.assign(make_move_iterator(stack.end() - argc),
+		make_move_iterator(stack.end()));
+	stack.resize(stack.size() - argc);
+	auto result = procedure.procedure()(arguments);
+	arguments.clear();
+	return result;
+}
+
+/* Runs the procedures that a.tail_call leaves behind until one of them
+ * returns a value, each in the frame of the one before it. result is
+ * returned if there are none. */
+Value run_tail_calls(Activation& a, Value result) {
+	auto& stack = *a.stack;
+	while (a.tail_call) {
+		a.tail_call = false;
+		auto procedure = move(a.procedure);
+		if (procedure.type() == Value::BuiltInProcedure)
+			return apply_builtin(a, procedure, a.argc);
+		if (procedure.type() != Value::Closure) {
+			throw InterpreterException("Undefined procedure: "
+				+ procedure.to_string() + ".");
+		}
+
+		a.frame.reset(procedure.function().frame_size, &procedure.captures());
+		a.context = &a.frame;
+		auto first = stack.size() - a.argc;
+		for (size_t i = 0; i < a.argc; ++i) 
+			a.frame.set(i, move(stack[first + i]));
+		stack.resize(first);
+
+		a.running = move(procedure);
+		result = a.running.function().body->evaluate(a);
+	}
+	return result;
+}
+
+class Constant : public Node {
+public:
+	Constant(Value value) : value_(move(value)) { }
+
+	Value evaluate(Activation&) const override { return value_; }
+
+private:
+	Value value_;
+};
+
+class GlobalRead : public Node {
+public:
+	GlobalRead(int symbol) : symbol_(symbol) { }
+
+	Value evaluate(Activation& a) const override {
+		const auto& v = a.context->get_global(symbol_);
+		if (not v.is_defined())
+			throw ContextException(SymbolTable::name(symbol_));
+		return v;
+	}
+
+private:
+	int symbol_;
+};
+
+/* Reads a slot of the frame, or a capture of the running closure, and the
+ * contents of the Box there if the variable has one. */
+template <bool Captured, bool Boxed>
+class LocalRead : public Node {
+public:
+	LocalRead(int index, int symbol) : index_(index), symbol_(symbol) { }
+
+	Value evaluate(Activation& a) const override {
+		const auto* v = Captured ? &a.context->get_capture(index_) 
+			: &a.context->get_slot(index_);
+		if (Boxed)
+			v = &v->contents();
+		if (not v->is_defined())
+			throw ContextException(SymbolTable::name(symbol_));
+		return *v;
+	}
+
+private:
+	int index_, symbol_;
+};
+
+class GlobalDefine : public Node {
+public:
+	GlobalDefine(int symbol, NodePointer value)
+		: symbol_(symbol), value_(move(value)) { }
+
+	Value evaluate(Activation& a) const override {
+		auto v = value_->evaluate(a);
+		a.context->set_global(symbol_, v);
+		return v;
+	}
+
+private:
+	int symbol_;
+
+	NodePointer value_;
+};
+
+template <bool Boxed>
+class LocalDefine : public Node {
+public:
+	LocalDefine(int slot, NodePointer value) 
+		: slot_(slot), value_(move(value)) { }
+
+	Value evaluate(Activation& a) const override {
+		auto v = value_->evaluate(a);
+		if (Boxed) {
+			a.context->get_slot(slot_).set_contents(v);
+		} else {
+			a.context->set(slot_, v);
+		}
+		return v;
+	}
+
+private:
+	int slot_;
+
+	NodePointer value_;
+};
+
+class If : public Node {
+public:
+	If(NodePointer test, NodePointer consequent, NodePointer alternative)
+		: test_(move(test)), consequent_(move(consequent)),
+		  alternative_(move(alternative)) { }
+
+	Value evaluate(Activation& a) const override {
+		return test_->evaluate(a).as_bool() ? consequent_->evaluate(a)
+			: alternative_->evaluate(a);
+	}
+
+private:
+	NodePointer test_, consequent_, alternative_;
+};
+
+class Sequence : public Node {
+public:
+	Sequence(NodePointers commands, NodePointer last)
+		: commands_(move(commands)), last_(move(last)) { }
+
+	Value evaluate(Activation& a) const override {
+		for (const auto& command : commands_) 
+			command->evaluate(a);
+		return last_->evaluate(a);
+	}
+
+private:
+	NodePointers commands_;
+
+	NodePointer last_;
+};
+
+/* Boxes the slots of the frame that need it before running a body. */
+class Boxes : public Node {
+public:
+	Boxes(vector<int> slots, NodePointer body)
+		: slots_(move(slots)), body_(move(body)) { }
+
+	Value evaluate(Activation& a) const override {
+		a.context->box(slots_);
+		return body_->evaluate(a);
+	}
+
+private:
+	vector<int> slots_;
+
+	NodePointer body_;
+};
+
+/* A local block at the top level: the sequence, run in a frame of its own. */
+class Local : public Node {
+public:
+	Local(int frame_size, NodePointer body)
+		: frame_size_(frame_size), body_(move(body)) { }
+
+	Value evaluate(Activation& a) const override {
+		Context frame(a.context->global(), frame_size_);
+		auto* outer = a.context;
+		a.context = &frame;
+		auto v = body_->evaluate(a);
+		a.context = outer;
+		return v;
+	}
+
+private:
+	int frame_size_;
+
+	NodePointer body_;
+};
+
+class MakeClosure : public Node {
+public:
+	MakeClosure(shared_ptr<const Function> function) 
+		: function_(move(function)) { }
+
+	Value evaluate(Activation& a) const override {
+		return Value::closure(function_, 
+			a.context->capture(function_->captures));
+	}
+
+private:
+	shared_ptr<const Function> function_;
+};
+
+/* A call whose procedure is bound to a global symbol, as nearly all are:
+ * the symbol is read directly instead of through a node, and a built-in
+ * is applied on the spot. */
+template <bool Tail>
+class GlobalCall : public Node {
+public:
+	GlobalCall(int symbol, NodePointers arguments)
+		: symbol_(symbol), arguments_(move(arguments)) { }
+
+	Value evaluate(Activation& a) const override {
+		Value procedure = a.context->get_global(symbol_);
+		if (not procedure.is_defined())
+			throw ContextException(SymbolTable::name(symbol_));
+		return apply(a, move(procedure), arguments_);
+	}
+
+	/* Shared with Call, which only differs in how it finds procedure. */
+	static Value apply(Activation& a, Value procedure, 
+					   const NodePointers& arguments) {
+		for (const auto& argument : arguments) 
+			a.stack->push_back(argument->evaluate(a));
+		if (procedure.type() == Value::BuiltInProcedure)
+			return apply_builtin(a, procedure, arguments.size());
+
+		/* Built-ins don't grow the native stack, so only closures are left
+		 * in tail position for whoever runs the body to call. */
+		if (Tail) {
+			a.procedure = move(procedure);
+			a.argc = arguments.size();
+			a.tail_call = true;
+			return Value();
+		}
+
+		Activation callee(a.context, a.stack, a.arguments);
+		callee.procedure = move(procedure);
+		callee.argc = arguments.size();
+		callee.tail_call = true;
+		return run_tail_calls(callee, Value());
+	}
+
+private:
+	int symbol_;
+
+	NodePointers arguments_;
+};
+
+template <bool Tail>
+class Call : public Node {
+public:
+	Call(NodePointer procedure, NodePointers arguments)
+		: procedure_(move(procedure)), arguments_(move(arguments)) { }
+
+	Value evaluate(Activation& a) const override {
+		return GlobalCall<Tail>::apply(a, procedure_->evaluate(a), arguments_);
+	}
+
+private:
+	NodePointer procedure_;
+
+	NodePointers arguments_;
+};
+
+template <bool Captured>
+NodePointer make_local_read(const Cell& c) {
+	if (c.is_boxed()) 
+		return make_unique<LocalRead<Captured, true>>(c.index(), c.symbol());
+	return make_unique<LocalRead<Captured, false>>(c.index(), c.symbol());
+}
+
+/* Wraps body in a node boxing slots first, if there are any. */
+NodePointer with_boxes(const vector<int>& slots, NodePointer body) {
+	if (slots.empty()) 
+		return body;
+	return make_unique<Boxes>(slots, move(body));
+}
+} // namespace
+
+Value ClosureCompiler::run(const Cell& c, shared_ptr<Context> ctx) {
+	auto node = compile(c, true);
+	Values stack, arguments;
+	Activation a(ctx.get(), &stack, &arguments);
+	auto result = node->evaluate(a);
+	return run_tail_calls(a, move(result));
+}
+
+ClosureCompiler::NodePointer ClosureCompiler::compile(const Cell& c, bool tail) {
+	if (c.type() == Cell::List and c.arity() == 0) 
+		return make_unique<Constant>(Value());
+
+	if (c.is_value()) {
+		if (c.type() == Cell::Symbol) 
+			return compile_symbol(c);
+		return make_unique<Constant>(Value::literal(c));
+	}
+
+	if (c.arg(0).type() == Cell::Symbol) {
+		const auto& first_argument = c.arg(0).value();
+
+		if (boost::starts_with(first_argument, "lambda")) {
+			return compile_lambda(c);
+		} else if (first_argument == "define") {
+			return compile_define(c);
+		} else if (first_argument == "if") {
+			return compile_if(c, tail);
+		} else if (first_argument == "local") {
+			return compile_local(c, tail);
+		} else if (first_argument == "begin") {
+			return compile_begin(c, tail);
+		}
+	}
+
+	return compile_call(c, tail);
+}
+
+ClosureCompiler::NodePointer ClosureCompiler::compile_symbol(const Cell& c) {
+	if (c.is_global()) 
+		return make_unique<GlobalRead>(c.symbol());
+	if (c.location() == Cell::Captured) 
+		return make_local_read<true>(c);
+	return make_local_read<false>(c);
+}
+
+ClosureCompiler::NodePointer ClosureCompiler::compile_lambda(const Cell& c) {
+	auto f = make_shared<Function>();
+	f->literal_type = c.literal_type();
+	f->source = c.value();
+	f->frame_size = c.frame_size();
+	f->captures = c.captures();
+	f->body = with_boxes(c.boxes(), compile(c.arg(2), true));
+	return make_unique<MakeClosure>(move(f));
+}
+
+ClosureCompiler::NodePointer ClosureCompiler::compile_define(const Cell& c) {
+	auto value = compile(c.arg(2), false);
+	const auto& name = c.arg(1);
+	if (name.is_global()) 
+		return make_unique<GlobalDefine>(name.symbol(), move(value));
+	if (name.is_boxed()) 
+		return make_unique<LocalDefine<true>>(name.index(), move(value));
+	return make_unique<LocalDefine<false>>(name.index(), move(value));
+}
+
+ClosureCompiler::NodePointer ClosureCompiler::compile_if(const Cell& c, bool tail) {
+	return make_unique<If>(compile(c.arg(1), false), compile(c.arg(2), tail),
+		compile(c.arg(3), tail));
+}
+
+ClosureCompiler::NodePointer ClosureCompiler::compile_local(const Cell& c, bool tail) {
+	NodePointers commands;
+	for (const auto& command : c.arg(1).args()) 
+		commands.push_back(compile(command, false));
+	NodePointer body = make_unique<Sequence>(move(commands), 
+		compile(c.arg(2), tail));
+	/* Only blocks outside of any lambda have a frame of their own. */
+	if (c.frame_size() == 0) 
+		return body;
+	return make_unique<Local>(c.frame_size(), 
+		with_boxes(c.boxes(), move(body)));
+}
+
+ClosureCompiler::NodePointer ClosureCompiler::compile_begin(const Cell& c, bool tail) {
+	if (c.arity() == 1) 
+		return make_unique<Constant>(Value());
+	NodePointers commands;
+	for (int i = 1; i < c.arity() - 1; ++i) 
+		commands.push_back(compile(c.arg(i), false));
+	return make_unique<Sequence>(move(commands), 
+		compile(c.arg(c.arity() - 1), tail));
+}
+
+ClosureCompiler::NodePointer ClosureCompiler::compile_call(const Cell& c, bool tail) {
+	NodePointers arguments;
+	for (int i = 1; i < c.arity(); ++i) 
+		arguments.push_back(compile(c.arg(i), false));
+
+	const auto& procedure = c.arg(0);
+	if (procedure.type() == Cell::Symbol and procedure.is_global()) {
+		if (tail) 
+			return make_unique<GlobalCall<true>>(procedure.symbol(), move(arguments));
+		return make_unique<GlobalCall<false>>(procedure.symbol(), move(arguments));
+	}
+	auto node = compile(procedure, false);
+	if (tail) 
+		return make_unique<Call<true>>(move(node), move(arguments));
+	return make_unique<Call<false>>(move(node), move(arguments));
+}
@@ -0,0 +1,61 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include "Node.h"
+
+class Cell;
+class Context;
+
+/* Third way of evaluating forms, between the Interpreter and the Compiler:
+ * each resolved form is translated once into a tree of Nodes, which then
+ * evaluate themselves. Lambdas are translated along with the form that
+ * contains them, into Functions whose body is a Node. */
+class ClosureCompiler {
+public:
+	/* Translates a resolved top-level form and runs it. */
+	static Value run(const Cell& c, std::shared_ptr<Context> ctx);
+
+private:
+	typedef std::unique_ptr<const Node> NodePointer;
+
+	/* If tail is set, the value of c is that of the enclosing body, so
+	 * calls in c become tail calls. */
+	static NodePointer compile(const Cell& c, bool tail);
+
+	static NodePointer compile_symbol(const Cell& c);
+
+	static NodePointer compile_lambda(const Cell& c);
+
+	static NodePointer compile_define(const Cell& c);
+
+	static NodePointer compile_if(const Cell& c, bool tail);
+
+	static NodePointer compile_local(const Cell& c, bool tail);
+
+	static NodePointer compile_begin(const Cell& c, bool tail);
+
+	static NodePointer compile_call(const Cell& c, bool tail);
+};
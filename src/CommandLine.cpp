@@ -23,10 +23,15 @@
 */
 #include "CommandLine.h"
 #include "Cell.h"
+#include "ClosureCompiler.h"
+#include "Value.h"
 #include "Parser.h"
 #include "Interpreter.h"
+#include "Resolver.h"
+#include "VirtualMachine.h"
 #include "Exceptions.h"
 #include "ParseExceptions.h"
+#include "bigint/WorkerPool.h"
 
 #include <vector>
 #include <iostream>
@@ -39,8 +44,11 @@
 
 using namespace std;
 
-CommandLine::CommandLine() {
+CommandLine::CommandLine(Engine engine, unsigned threads) : engine_(engine) {
 	quit_ = false;
+	if (threads != 0) {
+		WorkerPool::setMaxThreads(threads);
+	}
 	context_ = Context::global_context();
 }
 
@@ -65,8 +73,8 @@ void CommandLine::respond(const std::string& prompt) {
 
 			if (v.empty()) continue;
 		
-			auto result = Interpreter::interpret(v[0], context_);
-			cout << result.to_string() << ": " << result.literal_type() << endl;
+			auto result = evaluate(v[0]);
+			cout << result.to_string() << ": " << result.literal_type()->to_string() << endl;
 
 		} catch (GenericException& e) {
 			cout << e.what() << endl;
@@ -85,6 +93,12 @@ bool CommandLine::parse_additional_options(const string& s) {
 		return true;;
 	}
 
+	static boost::regex threads_regex("threads *([0-9]{1,4}) *", boost::regex::icase);
+	if (boost::regex_match(s, sm, threads_regex)) {
+		WorkerPool::setMaxThreads(stoul(sm[1].str()));
+		return true;
+	}
+
 	if (s == "reset") {
 		reset();
 		return true;
@@ -115,7 +129,7 @@ void CommandLine::load_file(const string& filename) {
 	try {
 		auto cells = Parser::parse(program);
 		for (auto& c : cells) {
-			Interpreter::interpret(c, context_);
+			evaluate(c);
 		}
 	} catch (std::exception& e) {		
 		cout << e.what() << endl;
@@ -126,4 +140,24 @@ void CommandLine::load_file(const string& filename) {
 void CommandLine::reset() {
 	context_.reset();
 	context_ = make_shared<Context>();
+	checker_ = TypeChecker();
+}
+
+Value CommandLine::evaluate(Cell& c) {
+	Parser::parse_lambdas(c);
+	Resolver::resolve(c);
+	checker_.check(c);
+	if (engine_ == VM) {
+		return VirtualMachine::run(c, context_);
+	}
+	if (engine_ == Closure) {
+		return ClosureCompiler::run(c, context_);
+	}
+#ifndef NDEBUG
+	auto copies = Cell::copies();
+#endif
+	auto result = Interpreter::interpret(move(c), context_);
+	/* The tree is shared by everything made from it, never copied. */
+	assert(Cell::copies() == copies);
+	return result;
 }
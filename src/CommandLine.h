@@ -26,10 +26,23 @@
 #include <string>
 #include <memory>
 #include "Context.h"
+#include "TypeChecker.h"
+
+class Cell;
+class Value;
 
 class CommandLine {
 public:
-	CommandLine();
+	/* How forms are evaluated: by walking the tree, by compiling them to
+	 * bytecode for the VirtualMachine, or by translating them into trees of
+	 * Nodes with the ClosureCompiler. */
+	enum Engine { Tree, VM, Closure };
+
+	/* `threads' caps the threads that arithmetic on huge integers may
+	 * use; 0 leaves the cap at the number of hardware threads. The cap
+	 * belongs to the process-wide WorkerPool, not to this CommandLine: the
+	 * threads command changes it for everyone, and reset keeps it. */
+	CommandLine(Engine engine = Tree, unsigned threads = 0);
 
 	void respond(const std::string& prompt);	
 
@@ -40,7 +53,13 @@ private:
 
 	void reset();
 
+	Value evaluate(Cell& c);
+
+	Engine engine_;
+
 	std::shared_ptr<Context> context_;
 
+	TypeChecker checker_;
+
 	bool quit_;
 };
\ No newline at end of file
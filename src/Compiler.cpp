@@ -0,0 +1,166 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "Compiler.h"
+#include "Cell.h"
+
+#include <ciso646>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+using namespace std;
+
+shared_ptr<const Function> Compiler::compile(const Cell& c) {
+	auto f = make_shared<Function>();
+	compile(c, *f, true);
+	emit(*f, Instruction::Return);
+	return f;
+}
+
+void Compiler::compile(const Cell& c, Function& f, bool tail) {
+	if (c.type() == Cell::List and c.arity() == 0) {
+		emit(f, Instruction::Constant, add_constant(f, Value()));
+		return;
+	}
+
+	if (c.is_value()) {
+		if (c.type() == Cell::Symbol) {
+			compile_symbol(c, f);
+		} else {
+			emit(f, Instruction::Constant, add_constant(f, Value::literal(c)));
+		}
+		return;
+	}
+
+	if (c.arg(0).type() == Cell::Symbol) {
+		const auto& first_argument = c.arg(0).value();
+
+		if (boost::starts_with(first_argument, "lambda")) {
+			return compile_lambda(c, f);
+		} else if (first_argument == "define") {
+			return compile_define(c, f);
+		} else if (first_argument == "if") {
+			return compile_if(c, f, tail);
+		} else if (first_argument == "local") {
+			return compile_local(c, f, tail);
+		} else if (first_argument == "begin") {
+			return compile_begin(c, f, tail);
+		}
+	}
+
+	compile_call(c, f, tail);
+}
+
+void Compiler::compile_symbol(const Cell& c, Function& f) {
+	if (c.is_global()) {
+		emit(f, Instruction::LoadGlobal, c.symbol());
+	} else {
+		auto op = c.location() == Cell::Slot ? Instruction::LoadLocal 
+			: Instruction::LoadCapture;
+		emit(f, op, c.index(), c.is_boxed(), c.symbol());
+	}
+}
+
+void Compiler::compile_lambda(const Cell& c, Function& f) {
+	auto g = make_shared<Function>();
+	g->literal_type = c.literal_type();
+	g->source = c.value();
+	g->frame_size = c.frame_size();
+	g->captures = c.captures();
+	for (int slot : c.boxes()) {
+		emit(*g, Instruction::MakeBox, slot);
+	}
+	compile(c.arg(2), *g, true);
+	emit(*g, Instruction::Return);
+
+	f.functions.push_back(move(g));
+	emit(f, Instruction::MakeClosure, f.functions.size() - 1);
+}
+
+void Compiler::compile_define(const Cell& c, Function& f) {
+	compile(c.arg(2), f, false);
+	const auto& name = c.arg(1);
+	if (name.is_global()) {
+		emit(f, Instruction::DefineGlobal, name.symbol());
+	} else {
+		emit(f, Instruction::DefineLocal, name.index(), name.is_boxed());
+	}
+}
+
+void Compiler::compile_if(const Cell& c, Function& f, bool tail) {
+	compile(c.arg(1), f, false);
+	int jump_to_else = emit(f, Instruction::JumpIfFalse);
+	compile(c.arg(2), f, tail);
+	int jump_to_end = emit(f, Instruction::Jump);
+	f.code[jump_to_else].a = f.code.size();
+	compile(c.arg(3), f, tail);
+	f.code[jump_to_end].a = f.code.size();
+}
+
+void Compiler::compile_local(const Cell& c, Function& f, bool tail) {
+	/* Only blocks outside of any lambda have a frame of their own. */
+	bool opens_frame = c.frame_size() > 0;
+	if (opens_frame) {
+		emit(f, Instruction::EnterFrame, c.frame_size());
+		for (int slot : c.boxes()) {
+			emit(f, Instruction::MakeBox, slot);
+		}
+	}
+	for (const auto& command : c.arg(1).args()) {
+		compile(command, f, false);
+		emit(f, Instruction::Pop);
+	}
+	compile(c.arg(2), f, tail);
+	if (opens_frame) {
+		emit(f, Instruction::LeaveFrame);
+	}
+}
+
+void Compiler::compile_begin(const Cell& c, Function& f, bool tail) {
+	if (c.arity() == 1) {
+		emit(f, Instruction::Constant, add_constant(f, Value()));
+		return;
+	}
+	for (int i = 1; i < c.arity() - 1; ++i) {
+		compile(c.arg(i), f, false);
+		emit(f, Instruction::Pop);
+	}
+	compile(c.arg(c.arity() - 1), f, tail);
+}
+
+void Compiler::compile_call(const Cell& c, Function& f, bool tail) {
+	for (const auto& a : c.args()) {
+		compile(a, f, false);
+	}
+	emit(f, tail ? Instruction::TailCall : Instruction::Call, c.arity() - 1);
+}
+
+int Compiler::emit(Function& f, Instruction::Opcode op, int a, int b, int c) {
+	f.code.push_back(Instruction{op, a, b, c});
+	return f.code.size() - 1;
+}
+
+int Compiler::add_constant(Function& f, Value v) {
+	f.constants.push_back(move(v));
+	return f.constants.size() - 1;
+}
@@ -0,0 +1,63 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include "Function.h"
+
+class Cell;
+
+/* Translates resolved top-level forms into bytecode for the VirtualMachine.
+ * Every lambda in the form is compiled once, here, into a Function of its
+ * own; evaluating the lambda later only pairs that Function with a frame. */
+class Compiler {
+public:
+	/* Compiles c into a function of no arguments that evaluates it in the
+	 * global context. */
+	static std::shared_ptr<const Function> compile(const Cell& c);
+
+private:
+	/* Emits code leaving the value of c on the stack. If tail is set, the
+	 * value is returned by f right away, so calls become tail calls. */
+	static void compile(const Cell& c, Function& f, bool tail);
+
+	static void compile_symbol(const Cell& c, Function& f);
+
+	static void compile_lambda(const Cell& c, Function& f);
+
+	static void compile_define(const Cell& c, Function& f);
+
+	static void compile_if(const Cell& c, Function& f, bool tail);
+
+	static void compile_local(const Cell& c, Function& f, bool tail);
+
+	static void compile_begin(const Cell& c, Function& f, bool tail);
+
+	static void compile_call(const Cell& c, Function& f, bool tail);
+
+	static int emit(Function& f, Instruction::Opcode op, int a = 0, int b = 0,
+		int c = 0);
+
+	static int add_constant(Function& f, Value v);
+};
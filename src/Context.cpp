@@ -24,27 +24,122 @@
 #include "Context.h"
 #include "InterpreterExceptions.h"
 #include "BuiltIns.h"
+#include "FrameArena.h"
+#include "SymbolTable.h"
 
+#include <ciso646>
 #include <iostream>
 
 using namespace std;
 
-Context::Context() {
-	for (const auto& c : BuiltIns::get()) {		
-		set(c.value(), c);
+Context::Context() 
+	: slots_(nullptr), size_(0), captures_(nullptr), global_(this), 
+	  arena_(new FrameArena) {
+	for (const auto& b : BuiltIns::get()) {		
+		Cell symbol(Cell::Symbol, b.first);
+		symbol.set_symbol(SymbolTable::intern(b.first));
+		set(symbol, b.second);
 	}
 }
 
-const Cell& Context::get(const std::string& s) const {
-	if (has_symbol(s)) 
-		return map_.find(s)->second;
-	if (outer_ != nullptr)
-		return outer_->get(s);
-	throw ContextException(s);
+Context::Context(Context* global, int size, const Values* captures)
+	: slots_(global->arena_->allocate(size)), size_(size), 
+	  captures_(captures), global_(global) {
 }
 
-void Context::set(const std::string& s, Cell c) {	
-	map_[s] = move(c);
+Context::Context(Context&& c) noexcept
+	: slots_(c.slots_), size_(c.size_), captures_(c.captures_), 
+	  global_(c.global_), bindings_(move(c.bindings_)), 
+	  arena_(move(c.arena_)) {
+	c.slots_ = nullptr;
+	c.size_ = 0;
+}
+
+Context::~Context() {
+	if (size_ > 0) 
+		global_->arena_->release(slots_, size_);
+}
+
+const Value& Context::get(const Cell& symbol) const {
+	const Value* v;
+	switch (symbol.location()) {
+	case Cell::Global:
+		v = &get_global(symbol.symbol());
+		break;
+	case Cell::Slot:
+		v = &slots_[symbol.index()];
+		break;
+	case Cell::Captured:
+		v = &(*captures_)[symbol.index()];
+		break;
+	default:
+		throw InterpreterException::undefined();
+	}
+	if (symbol.is_boxed())
+		v = &v->contents();
+	if (not v->is_defined())
+		throw ContextException(symbol.value());
+	return *v;
+}
+
+void Context::set(const Cell& symbol, Value v) {	
+	if (symbol.is_global()) {
+		set_global(symbol.symbol(), move(v));
+	} else if (symbol.is_boxed()) {
+		slots_[symbol.index()].set_contents(move(v));
+	} else {
+		/* Definitions always bind in the innermost frame. */
+		slots_[symbol.index()] = move(v);
+	}
+}
+
+const Value& Context::get_global(int symbol) const {
+	static const Value undefined = Value::undefined();
+	const auto& bindings = global_->bindings_;
+	return symbol < (int)bindings.size() ? bindings[symbol] : undefined;
+}
+
+void Context::set_global(int symbol, Value v) {
+	auto& bindings = global_->bindings_;
+	if (symbol >= (int)bindings.size())
+		bindings.resize(SymbolTable::size(), Value::undefined());
+	bindings[symbol] = move(v);
+}
+
+void Context::box(const vector<int>& slots) {
+	for (int slot : slots)
+		slots_[slot] = Value::box(move(slots_[slot]));
+}
+
+Values Context::capture(const vector<Cell::Capture>& captures) const {
+	Values values;
+	values.reserve(captures.size());
+	for (const auto& c : captures) {
+		values.push_back(c.location == Cell::Slot ? slots_[c.index] 
+			: (*captures_)[c.index]);
+	}
+	return values;
+}
+
+void Context::reset(int size, const Values* captures) {
+	if (size == size_) {
+		for (int i = 0; i < size_; ++i) 
+			slots_[i] = Value::undefined();
+	} else {
+		auto& arena = *global_->arena_;
+		arena.release(slots_, size_);
+		slots_ = arena.allocate(size);
+		size_ = size;
+	}
+	captures_ = captures;
+}
+
+void Context::replace(Context&& callee) {
+	slots_ = global_->arena_->lower(callee.slots_, callee.size_, slots_, size_);
+	size_ = callee.size_;
+	captures_ = callee.captures_;
+	callee.slots_ = nullptr;
+	callee.size_ = 0;
 }
 
 std::shared_ptr<Context> Context::global_context() {
@@ -52,6 +147,6 @@ std::shared_ptr<Context> Context::global_context() {
 	return context;
 }
 
-bool Context::has_symbol(const std::string& s) const {
-	return map_.find(s) != map_.end();
+bool Context::has_symbol(int symbol) const {
+	return symbol < (int)bindings_.size() and bindings_[symbol].is_defined();
 }
@@ -23,29 +23,93 @@
 */
 #pragma once
 
-#include <string>
-#include <unordered_map>
 #include <memory>
 #include "Cell.h"
+#include "Value.h"
 
+class FrameArena;
+
+/* A frame of bindings. The global context keeps its bindings indexed by
+ * symbol id; every other context is a fixed-size frame opened by a lambda
+ * call or a local block, whose slots were assigned by the Resolver. A
+ * lambda's frame also sees the captures of the closure being run, which
+ * must outlive it. 
+ *
+ * Frames don't refer to each other and nothing keeps them past the call
+ * that opened them, so their slots come from the FrameArena of the global
+ * context, and the evaluators keep the frames themselves in place of
+ * allocating them: a frame must be destroyed before any opened ahead of
+ * it. */
 class Context {
 public:
 	Context();
 
-	Context(std::shared_ptr<Context> outer) : outer_(outer) { }
+	Context(Context* global, int size, const Values* captures = nullptr);
+
+	Context(Context&& c) noexcept;
+
+	Context(const Context&) = delete;
+
+	Context& operator=(const Context&) = delete;
+
+	~Context();
+
+	/* Reads a variable, through its Box if it has one. */
+	const Value& get(const Cell& symbol) const;
+
+	/* Defines a variable, in its Box if it has one. */
+	void set(const Cell& symbol, Value v);
+
+	void set(int slot, Value v) { slots_[slot] = std::move(v); }
+
+	/* Unchecked accessors; the result may be undefined, or a Box. */
+	const Value& get_slot(int slot) const { return slots_[slot]; }
+
+	Value& get_slot(int slot) { return slots_[slot]; }
+
+	const Value& get_capture(int index) const { return (*captures_)[index]; }
 
-	const Cell& get(const std::string& s) const;
+	const Value& get_global(int symbol) const;
 
-	void set(const std::string& s, Cell c);	
+	void set_global(int symbol, Value v);
 
-	bool has_symbol(const std::string& s) const;
+	/* Puts the value of each of the slots in a Box. */
+	void box(const std::vector<int>& slots);
+
+	/* Values of the captures of the variables in lambda's frame, to make a
+	 * closure over it. */
+	Values capture(const std::vector<Cell::Capture>& captures) const;
+
+	/* Empties the frame and makes it size slots, for a tail call to a
+	 * closure with captures. Only the frame opened last can be reset. */
+	void reset(int size, const Values* captures);
+
+	/* Takes the place of callee, the frame opened right after this one,
+	 * freeing this one's slots. This lets a tail call evaluate its
+	 * arguments into its frame before the caller's frame goes away. */
+	void replace(Context&& callee);
+
+	int size() const { return size_; }
+
+	bool has_symbol(int symbol) const;
+
+	bool is_global() const { return global_ == this; }
+
+	Context* global() const { return global_; }
 
 	static std::shared_ptr<Context> global_context();
 
 private:
+	Value* slots_;
 
-	std::unordered_map<std::string, Cell> map_;
+	int size_;
 
-	std::shared_ptr<Context> outer_;
-};
+	const Values* captures_;
+
+	Context* global_;
 
+	/* Only used by the global context. */
+	Values bindings_;
+
+	std::unique_ptr<FrameArena> arena_;
+};
@@ -0,0 +1,109 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <ciso646>
+
+using namespace std;
+
+Value* FrameArena::allocate(int size) {
+	if (size == 0) 
+		return nullptr;
+
+	if (blocks_.empty()) 
+		blocks_.push_back(Block{nullptr, 0, 0});
+	if (blocks_[current_].capacity - blocks_[current_].used < size) {
+		/* Blocks past the current one are empty, and reused when they are
+		 * big enough. */
+		if (blocks_[current_].used > 0) 
+			++current_;
+		if (current_ == (int)blocks_.size()) 
+			blocks_.push_back(Block{nullptr, 0, 0});
+		auto& block = blocks_[current_];
+		if (block.capacity < size) {
+			block.capacity = max(size, int(block_size));
+			block.slots.reset(new Value[block.capacity]);
+			clear(block.slots.get(), block.capacity);
+		}
+	}
+
+	auto& block = blocks_[current_];
+	auto* slots = block.slots.get() + block.used;
+	block.used += size;
+	return slots;
+}
+
+void FrameArena::release(Value* slots, int size) {
+	if (size == 0) 
+		return;
+
+	auto& block = blocks_[current_];
+	assert(slots == block.slots.get() + block.used - size);
+	clear(slots, size);
+	block.used -= size;
+	settle();
+}
+
+Value* FrameArena::lower(Value* slots, int size, Value* below, 
+	int below_size) {
+	if (below_size == 0) 
+		return slots;
+	if (size == 0) {
+		release(below, below_size);
+		return nullptr;
+	}
+
+	auto& block = blocks_[current_];
+	assert(slots == block.slots.get() + block.used - size);
+	if (slots != block.slots.get()) {
+		/* Both are in this block: slide the topmost one down. */
+		assert(below == slots - below_size);
+		move(slots, slots + size, below);
+		clear(below + size, below_size);
+		block.used -= below_size;
+		return below;
+	}
+
+	/* The topmost frame starts this block, and the one below ends the
+	 * last block in use before it. */
+	int previous = current_ - 1;
+	while (blocks_[previous].used == 0) 
+		--previous;
+	auto& other = blocks_[previous];
+	assert(below == other.slots.get() + other.used - below_size);
+	clear(below, below_size);
+	other.used -= below_size;
+	return slots;
+}
+
+void FrameArena::clear(Value* slots, int size) {
+	fill(slots, slots + size, Value::undefined());
+}
+
+void FrameArena::settle() {
+	while (current_ > 0 and blocks_[current_].used == 0) 
+		--current_;
+}
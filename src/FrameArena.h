@@ -0,0 +1,71 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Value.h"
+
+/* Storage for the slots of frames. Closures copy the values they capture,
+ * and the variables that must be shared are in Boxes on the heap, so no
+ * frame outlives the call or local block that opened it: frames are freed
+ * in the reverse order of their allocation, and a stack is all they need.
+ * It is kept in blocks that are never given back, so once the deepest
+ * recursion of a session has been reached, calls allocate nothing. */
+class FrameArena {
+public:
+	/* size undefined slots, on top of the frames allocated so far. */
+	Value* allocate(int size);
+
+	/* Frees the topmost frame, which has size slots. */
+	void release(Value* slots, int size);
+
+	/* Frees the frame right under the topmost one, moving the topmost one
+	 * down over it if they are in the same block. Returns where the
+	 * topmost one now is. */
+	Value* lower(Value* slots, int size, Value* below, int below_size);
+
+private:
+	struct Block {
+		std::unique_ptr<Value[]> slots;
+
+		int capacity;
+
+		int used;
+	};
+
+	/* Sets the slots to undefined, dropping what they refer to. */
+	static void clear(Value* slots, int size);
+
+	/* Steps back over the blocks left empty, to the one holding the
+	 * topmost frame. */
+	void settle();
+
+	/* Slots per block, unless a frame needs more. */
+	static const int block_size = 4096;
+
+	std::vector<Block> blocks_;
+
+	int current_ = 0;
+};
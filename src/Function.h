@@ -0,0 +1,102 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Cell.h"
+#include "Value.h"
+
+class Node;
+
+/* One virtual machine instruction. Operands a, b and c are interpreted per
+ * opcode, as described next to each one. */
+struct Instruction {
+	enum Opcode : uint8_t {
+		/* Push constants[a]. */
+		Constant,
+		/* Push global symbol a. */
+		LoadGlobal,
+		/* Push slot a of the current frame, or the contents of the Box there
+		 * if b is set; c is the symbol, for errors. */
+		LoadLocal,
+		/* Same as LoadLocal, for capture a of the running closure. */
+		LoadCapture,
+		/* Bind global symbol a to the top of the stack, leaving it there. */
+		DefineGlobal,
+		/* Bind slot a of the current frame to the top of the stack, through
+		 * the Box there if b is set. */
+		DefineLocal,
+		/* Put the value of slot a of the current frame in a Box. */
+		MakeBox,
+		Pop,
+		/* Continue at instruction a. */
+		Jump,
+		/* Pop a bool and continue at instruction a if it is false. */
+		JumpIfFalse,
+		/* Push a closure of functions[a], capturing its free variables from
+		 * the current frame. */
+		MakeClosure,
+		/* Call the procedure below the a topmost values with them as its
+		 * arguments. */
+		Call,
+		/* Same as Call, but reuses the current activation. */
+		TailCall,
+		/* Return the top of the stack to the caller. */
+		Return,
+		/* Open a frame of a slots for a local block at the top level. */
+		EnterFrame,
+		/* Close the frame opened by the matching EnterFrame. */
+		LeaveFrame
+	};
+
+	Opcode op;
+
+	int a, b, c;
+};
+
+/* A compiled lambda or top-level form. It is built once, when its source
+ * is compiled, and shared by every closure created from it. */
+struct Function {
+	const LiteralType* literal_type = nullptr;
+
+	/* What printing a closure over this function shows. */
+	std::string source;
+
+	int frame_size = 0;
+
+	/* Where closures over this function take their captures from. */
+	std::vector<Cell::Capture> captures;
+
+	std::vector<Instruction> code;
+
+	Values constants;
+
+	std::vector<std::shared_ptr<const Function>> functions;
+
+	/* What the ClosureCompiler translated the body into, instead of code. */
+	std::shared_ptr<const Node> body;
+};
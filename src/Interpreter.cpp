@@ -24,8 +24,7 @@
 #include "Interpreter.h"
 #include "Context.h"
 #include "InterpreterExceptions.h"
-#include "Parser.h"
-#include "Validator.h"
+#include "Value.h"
 
 #include <cassert>
 #include <iostream>
@@ -35,136 +34,134 @@
 
 using namespace std;
 
-Cell Interpreter::interpret(const Cell& c, shared_ptr<Context> ctx) {
-	if (c.is_value()) {					
-		return (c.type() == Cell::Symbol) ? ctx->get(c.value()) : c;		
-	}
-
-	if (c.arity() == 0) {
-		return Cell::empty_cell();
-	}
-
-	// cout << c.to_string() << endl;
-
-	if (c.arg(0).type() == Cell::Symbol) {
-		const auto& first_argument = c.arg(0).value();
-		auto r = c;
-
-		if (boost::starts_with(first_argument, "lambda")) {
-			return interpret_lambda(r, ctx);
-		} else if (first_argument == "define") {	
-			return interpret_define(r, ctx);
-		} else if (first_argument == "if") {
-			return interpret_if(r, ctx);
-		} else if (first_argument == "local") {
-			return interpret_local(r, ctx);
-		} else if (first_argument == "begin") {
-			return interpret_begin(r, ctx);
-		} 
-	} 	
-
-	/* it's a function call */	
-	auto r = interpret(c.arg(0), ctx);
-	Cells args;
-	for (int i = 1; i < c.arity(); ++i) {
-		args.push_back(interpret(c.arg(i), ctx));
-	}
-
-	if (r.type() == Cell::Lambda) {
-
-		auto new_ctx = make_shared<Context>((r.context() != nullptr) ? 
-			r.context() : ctx);
-		
-		Validator::assert_arity(c.arg(0).value(), r.arg(1).arity(), args);
+Value Interpreter::interpret(Cell form, shared_ptr<Context> ctx) {
+	auto owner = make_shared<const Cell>(move(form));
+	return interpret(*owner, owner, *ctx);
+}
 
-		for (int i = 0; i < r.arg(1).arity(); ++i) {			
-			Validator::assert_type(r.arg(0).value(),
-				r.arg(1).arg(i).literal_type(), args[i]);
-			new_ctx->set(r.arg(1).arg(i).value(), args[i]);
+Value Interpreter::interpret(const Cell& form, 
+							 const shared_ptr<const Cell>& form_owner,
+							 Context& form_context) {
+	/* Expressions in tail position replace the one being evaluated rather
+	 * than being interpreted recursively, so tail calls use no native
+	 * stack. procedure keeps the lambda whose body is being run alive, and
+	 * with it the tree that owner points to and the captures ctx reads. */
+	const Cell* c = &form;
+	const shared_ptr<const Cell>* owner = &form_owner;
+	Value procedure;
+
+	/* The frame of the lambda being run once this has made a tail call,
+	 * which every further tail call takes over. */
+	Context* ctx = &form_context;
+	Context frame(ctx->global(), 0);
+
+	while (true) {
+		if (c->type() == Cell::List and c->arity() == 0) {
+			return Value();
 		}
 
-		return interpret(r.arg(2), new_ctx);
+		if (c->is_value()) {					
+			return (c->type() == Cell::Symbol) ? ctx->get(*c) : Value::literal(*c);		
+		}
 
-	} else /* If r.type() == Cell::Procedure */ { 	
-		if (r.procedure() == nullptr) {
-			throw InterpreterException("Undefined procedure: " 
-				+ r.value() + ".");
+		// cout << c->to_string() << endl;
+
+		if (c->arg(0).type() == Cell::Symbol) {
+			const auto& first_argument = c->arg(0).value();
+
+			if (boost::starts_with(first_argument, "lambda")) {
+				return interpret_lambda(*c, *owner, *ctx);
+			} else if (first_argument == "define") {	
+				return interpret_define(*c, *owner, *ctx);
+			} else if (first_argument == "if") {
+				c = &interpret_if(*c, *owner, *ctx);
+				continue;
+			} else if (first_argument == "local") {
+				c = &interpret_local(*c, *owner, ctx, frame);
+				continue;
+			} else if (first_argument == "begin") {
+				c = &interpret_begin(*c, *owner, *ctx);
+				continue;
+			} 
+		} 	
+
+		/* it's a function call */	
+		auto r = interpret(c->arg(0), *owner, *ctx);
+
+		if (r.type() == Value::Lambda) {
+			const auto& lambda = r.lambda();
+
+			/* The arguments go straight into the callee's frame, which then
+			 * takes the place of the one this was running in, if any. */
+			Context callee(ctx->global(), lambda.frame_size(), &r.captures());
+			for (int i = 1; i < c->arity(); ++i) {			
+				callee.set(i - 1, interpret(c->arg(i), *owner, *ctx));
+			}
+			callee.box(lambda.boxes());
+			frame.replace(move(callee));
+			ctx = &frame;
+
+			procedure = move(r);
+			owner = &procedure.shared_lambda();
+			c = &procedure.lambda().arg(2);
+			continue;
 		}
-		
-		return r.procedure()(args);		
-	}	
 
-	throw InterpreterException::undefined(); 
-}
+		Values args;
+		args.reserve(c->arity() - 1);
+		for (int i = 1; i < c->arity(); ++i) {
+			args.push_back(interpret(c->arg(i), *owner, *ctx));
+		}
 
-Cell Interpreter::interpret_if(Cell& c, shared_ptr<Context> ctx) {
-	Validator::assert_arity("if", 3, c.args().size() - 1);
-	auto test = interpret(c.arg(1), ctx);
-	Validator::assert_type("if's test", "bool", test);
-	if (test.value() == "true") {
-		return interpret(c.arg(2), ctx);
-	}  else {
-		return interpret(c.arg(3), ctx);
+		if (r.type() == Value::BuiltInProcedure) { 	
+			return r.procedure()(args);		
+		} else {
+			throw InterpreterException("Undefined procedure: " 
+				+ r.to_string() + ".");
+		}	
 	}
 }
 
-Cell Interpreter::interpret_lambda(Cell& c, shared_ptr<Context> ctx) {	
-	Validator::assert_arity("lambda", 2, c.args().size() - 1);
-
-	c.set_type(Cell::Lambda);	
-	auto lambda_return_type = Parser::parse_value_and_type(c.arg(0).value());
-	if (not (boost::starts_with(lambda_return_type.first, "lambda")))
-		throw InterpreterException::undefined();
-	auto& return_type = lambda_return_type.second;
-
-	for (auto& a : c.arg(1).args()) {
-		auto value_type = Parser::parse_value_and_type(a.value());
-		a.set_value(value_type.first);
-		a.set_literal_type(value_type.second);
-	}
-	
-	string literal_type;
-	if (c.arg(1).arity() == 0) {
-		literal_type = "nothing";
-	} else {
-		literal_type = c.arg(1).arg(0).literal_type();
-		for (int i = 1; i < c.arg(1).arity(); ++i) {
-			literal_type += "," + c.arg(1).arg(i).literal_type();
-		}
-	}
-	literal_type += "->" + return_type;
-	c.set_literal_type(literal_type);
-	c.set_value("lambda:" + c.literal_type());	
-	c.arg(0).set_value("lambda:" + c.literal_type());
-	c.arg(0).set_literal_type(c.literal_type());
-
-	return c;
+const Cell& Interpreter::interpret_if(const Cell& c, 
+									  const shared_ptr<const Cell>& owner,
+									  Context& ctx) {
+	auto test = interpret(c.arg(1), owner, ctx);
+	return test.as_bool() ? c.arg(2) : c.arg(3);
 }
 
-Cell Interpreter::interpret_define(Cell& c, shared_ptr<Context> ctx) {
-	Validator::assert_arity("define", 2, c.args().size() - 1);
-	ctx->set(c.arg(1).value(), interpret(c.arg(2), ctx));
-	return ctx->get(c.arg(1).value());
+Value Interpreter::interpret_lambda(const Cell& c, 
+								   const shared_ptr<const Cell>& owner,
+								   Context& ctx) {	
+	return Value::lambda(shared_ptr<const Cell>(owner, &c), 
+		ctx.capture(c.captures()));
 }
 
-Cell Interpreter::interpret_local(Cell& c, shared_ptr<Context> ctx) {
-	Validator::assert_arity("local", 2, c.args().size() - 1);
-	auto new_ctx = make_shared<Context>(ctx);
-	interpret_command_list(c.arg(1), new_ctx);
-	c.arg(2) = interpret(c.arg(2), new_ctx);
-	c.arg(2).set_context(new_ctx);
-	return c.arg(2);
+Value Interpreter::interpret_define(const Cell& c, 
+								   const shared_ptr<const Cell>& owner,
+								   Context& ctx) {
+	ctx.set(c.arg(1), interpret(c.arg(2), owner, ctx));
+	return ctx.get(c.arg(1));
 }
 
-Cell Interpreter::interpret_begin(Cell& c, std::shared_ptr<Context> ctx) {
-	c.pop_first_arg();
-	return interpret_command_list(c, ctx);
+const Cell& Interpreter::interpret_local(const Cell& c, 
+										 const shared_ptr<const Cell>& owner,
+										 Context*& ctx, Context& frame) {
+	if (c.frame_size() > 0) {
+		frame.replace(Context(ctx->global(), c.frame_size()));
+		ctx = &frame;
+		ctx->box(c.boxes());
+	}
+	for (const auto& command : c.arg(1).args()) {
+		interpret(command, owner, *ctx);
+	}
+	return c.arg(2);
 }
 
-Cell Interpreter::interpret_command_list(const Cell& c,
-										 shared_ptr<Context> ctx) {
-	for (int i = 0; i < c.arity() - 1; ++i) {
-		interpret(c.arg(i), ctx);
+const Cell& Interpreter::interpret_begin(const Cell& c, 
+										 const shared_ptr<const Cell>& owner,
+										 Context& ctx) {
+	for (int i = 1; i < c.arity() - 1; ++i) {
+		interpret(c.arg(i), owner, ctx);
 	}
-	return interpret(c.arg(c.arity() - 1), ctx);	
+	return c.arg(c.arity() - 1);
 }
@@ -28,24 +28,43 @@
 
 class Cell;
 class Context;
+class Value;
 
 class Interpreter {
 public:	
-	static Cell interpret(const Cell& c, std::shared_ptr<Context> ctx);				
+	/* Interprets a resolved top-level form. From here on the form is shared,
+	 * unchanged, by the lambdas made from it, so nothing is copied. */
+	static Value interpret(Cell form, std::shared_ptr<Context> ctx);				
 
 private:
+	/* owner keeps alive the tree c belongs to. */
+	static Value interpret(const Cell& c, 
+						   const std::shared_ptr<const Cell>& owner,
+						   Context& ctx);
 
-	static Cell interpret_if(Cell& c, std::shared_ptr<Context> ctx);
+	/* The helpers for forms whose value is that of a subexpression in tail
+	 * position evaluate everything else, and return that subexpression for
+	 * interpret to continue with. */
+	static const Cell& interpret_if(const Cell& c, 
+									const std::shared_ptr<const Cell>& owner,
+									Context& ctx);
 
-	static Cell interpret_lambda(Cell& c, std::shared_ptr<Context> ctx);
+	static Value interpret_lambda(const Cell& c, 
+								  const std::shared_ptr<const Cell>& owner,
+								  Context& ctx);
 
-	static Cell interpret_define(Cell& c, std::shared_ptr<Context> ctx);
+	static Value interpret_define(const Cell& c, 
+								  const std::shared_ptr<const Cell>& owner,
+								  Context& ctx);
 
-	static Cell interpret_local(Cell& c, std::shared_ptr<Context> ctx);
+	/* Makes frame the block's frame and points ctx to it, if the block
+	 * opens one. */
+	static const Cell& interpret_local(const Cell& c, 
+									   const std::shared_ptr<const Cell>& owner,
+									   Context*& ctx, Context& frame);
 
-	static Cell interpret_begin(Cell& c, std::shared_ptr<Context> ctx);	
-
-	static Cell interpret_command_list(const Cell& c, 
-									   std::shared_ptr<Context> ctx);
+	static const Cell& interpret_begin(const Cell& c, 
+									   const std::shared_ptr<const Cell>& owner,
+									   Context& ctx);
 };
 
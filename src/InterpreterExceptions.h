@@ -56,4 +56,13 @@ struct TypeException : public InterpreterException {
 			"argument of type " + expected_type + ", given "
 			+ given_type + ".") {
 	}
-};
\ No newline at end of file
+};
+
+struct DomainException : public InterpreterException {
+	DomainException(const std::string& function_name,
+					const std::string& expected,
+					const std::string& given)
+		: InterpreterException("Error: " + function_name + " expects "
+			+ expected + ", given " + given + ".") {
+	}
+};
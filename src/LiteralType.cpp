@@ -0,0 +1,163 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "LiteralType.h"
+#include "InterpreterExceptions.h"
+
+#include <ciso646>
+#include <cctype>
+#include <map>
+#include <memory>
+#include <tuple>
+
+using namespace std;
+
+LiteralType::LiteralType(Kind kind, vector<const LiteralType*> arguments,
+						 bool variadic, char name) 
+	: kind_(kind), arguments_(move(arguments)), variadic_(variadic), 
+	  name_(name) {
+	switch (kind_) {
+	case Int:
+		string_ = "int";
+		break;
+	case Bool:
+		string_ = "bool";
+		break;
+	case String:
+		string_ = "string";
+		break;
+	case List:
+		string_ = "[" + (element() ? element()->to_string() : "") + "]";
+		break;
+	case Variable:
+		string_ = std::string(1, name_);
+		break;
+	case Function:
+		if (variadic_) {
+			const auto& p = parameter(0)->to_string();
+			string_ = p + "," + p + ",...," + p;
+		} else if (arity() == 0) {
+			string_ = "nothing";
+		} else {
+			for (int i = 0; i < arity(); ++i) {
+				string_ += (i > 0 ? "," : "") + parameter(i)->to_string();
+			}
+		}
+		string_ += "->" + result()->to_string();
+		break;
+	}
+}
+
+const LiteralType* LiteralType::intern(Kind kind, 
+	vector<const LiteralType*> arguments, bool variadic, char name) {
+	typedef tuple<Kind, vector<const LiteralType*>, bool, char> Key;
+	static map<Key, unique_ptr<LiteralType>> types;
+
+	auto& type = types[Key(kind, arguments, variadic, name)];
+	if (not type) {
+		type.reset(new LiteralType(kind, move(arguments), variadic, name));
+	}
+	return type.get();
+}
+
+const LiteralType* LiteralType::integer() {
+	static const auto type = intern(Int, {});
+	return type;
+}
+
+const LiteralType* LiteralType::boolean() {
+	static const auto type = intern(Bool, {});
+	return type;
+}
+
+const LiteralType* LiteralType::string() {
+	static const auto type = intern(String, {});
+	return type;
+}
+
+const LiteralType* LiteralType::empty() {
+	static const auto type = intern(List, {nullptr});
+	return type;
+}
+
+const LiteralType* LiteralType::list(const LiteralType* element) {
+	if (not element) return empty();
+	if (not element->list_) element->list_ = intern(List, {element});
+	return element->list_;
+}
+
+const LiteralType* LiteralType::function(
+	const vector<const LiteralType*>& parameters, const LiteralType* result,
+	bool variadic) {
+	auto arguments = parameters;
+	arguments.push_back(result);
+	return intern(Function, move(arguments), variadic);
+}
+
+const LiteralType* LiteralType::variable(char name) {
+	return intern(Variable, {}, false, name);
+}
+
+const LiteralType* LiteralType::parse(const std::string& s) {
+	/* Split at the first arrow outside brackets. */
+	int depth = 0;
+	for (size_t i = 0; i + 1 < s.size(); ++i) {
+		if (s[i] == '[') ++depth;
+		if (s[i] == ']') --depth;
+		if (depth > 0 or s[i] != '-' or s[i + 1] != '>') continue;
+
+		vector<const LiteralType*> parameters;
+		bool variadic = false;
+		auto list = s.substr(0, i);
+		if (list != "nothing") {
+			size_t start = 0;
+			for (size_t j = 0; j <= list.size(); ++j) {
+				if (j < list.size() and list[j] == '[') ++depth;
+				if (j < list.size() and list[j] == ']') --depth;
+				if (j < list.size() and (list[j] != ',' or depth > 0)) continue;
+
+				auto parameter = list.substr(start, j - start);
+				start = j + 1;
+				if (parameter == "...") {
+					variadic = true;
+				} else if (not variadic) {
+					parameters.push_back(parse(parameter));
+				}
+			}
+			if (variadic) parameters.resize(1);
+		}
+		return function(parameters, parse(s.substr(i + 2)), variadic);
+	}
+
+	if (s == "int") return integer();
+	if (s == "bool") return boolean();
+	if (s == "string") return string();
+
+	if (s.size() >= 2 and s.front() == '[' and s.back() == ']') {
+		return s.size() == 2 ? empty() : list(parse(s.substr(1, s.size() - 2)));
+	}
+
+	if (s.size() == 1 and isalpha(s[0])) return variable(s[0]);
+
+	throw InterpreterException("Error: unknown type " + s + ".");
+}
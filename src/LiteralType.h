@@ -0,0 +1,108 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <string>
+#include <vector>
+
+/* The type of a literal, value or annotation. Types are interned: each
+ * distinct type is described by exactly one immutable LiteralType, so two
+ * types are equal exactly when their pointers are, and a type's structure
+ * and printed form are computed only once, when it is first made. */
+class LiteralType {
+public:
+	enum Kind {
+		Int,
+		Bool,
+		String,
+		List,
+		Function,
+		/* A type variable, named by one letter, as in x->bool. */
+		Variable
+	};
+
+	static const LiteralType* integer();
+
+	static const LiteralType* boolean();
+
+	static const LiteralType* string();
+
+	/* The type of empty, a list whose element type isn't known. */
+	static const LiteralType* empty();
+
+	static const LiteralType* list(const LiteralType* element);
+
+	/* A variadic function takes any number of arguments of its one
+	 * parameter type. */
+	static const LiteralType* function(
+		const std::vector<const LiteralType*>& parameters, 
+		const LiteralType* result, bool variadic = false);
+
+	static const LiteralType* variable(char name);
+
+	/* Reads the notation of annotations: int, bool, string, [T], x,
+	 * T1,...,Tn->T (nothing->T if there are no parameters) and
+	 * T,T,...,T->T for variadic functions. Arrows associate to the right. */
+	static const LiteralType* parse(const std::string& s);
+
+	Kind kind() const { return kind_; }
+
+	/* Null for the type of empty. */
+	const LiteralType* element() const { return arguments_[0]; }
+
+	int arity() const { return arguments_.size() - 1; }
+
+	const LiteralType* parameter(int i) const { return arguments_[i]; }
+
+	const LiteralType* result() const { return arguments_.back(); }
+
+	bool is_variadic() const { return variadic_; }
+
+	char name() const { return name_; }
+
+	const std::string& to_string() const { return string_; }
+
+private:
+	LiteralType(Kind kind, std::vector<const LiteralType*> arguments,
+		bool variadic, char name);
+
+	static const LiteralType* intern(Kind kind, 
+		std::vector<const LiteralType*> arguments, bool variadic = false, 
+		char name = 0);
+
+	Kind kind_;
+
+	/* The element of a List; the parameters and then the result of a
+	 * Function. */
+	std::vector<const LiteralType*> arguments_;
+
+	bool variadic_;
+
+	char name_;
+
+	std::string string_;
+
+	/* Memoizes list(this), which built-ins ask for on every cons. */
+	mutable const LiteralType* list_ = nullptr;
+};
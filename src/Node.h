@@ -0,0 +1,72 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include "Context.h"
+#include "Value.h"
+
+/* State of a running procedure body, threaded through its nodes. */
+struct Activation {
+	/* Starts out in context, until it runs a procedure. */
+	Activation(Context* context, Values* stack, Values* arguments)
+		: context(context), frame(context->global(), 0), stack(stack),
+		  arguments(arguments) { }
+
+	Context* context;
+
+	/* The frame of the procedure being run, which context then points to.
+	 * Each procedure run in turn takes it over. */
+	Context frame;
+
+	/* Shared by every activation of a top-level form: calls evaluate their
+	 * arguments onto the stack, and built-ins get them in the buffer. */
+	Values* stack;
+
+	Values* arguments;
+
+	/* Set by a call in tail position, which leaves the procedure here and
+	 * its argc arguments on the stack for whoever is running the body to
+	 * apply, instead of applying them on top of the native stack. */
+	bool tail_call = false;
+
+	Value procedure;
+
+	size_t argc = 0;
+
+	/* Keeps the procedure whose body is running alive. */
+	Value running;
+};
+
+/* A form translated by the ClosureCompiler. Each kind of node does one
+ * thing, with everything the Interpreter would work out from the Cell on
+ * every evaluation (which special form it is, where a symbol lives, how many
+ * arguments a call has) decided at translation time. */
+class Node {
+public:
+	virtual ~Node() { }
+
+	/* The value of the form in a.context, unless it ends in a tail call. */
+	virtual Value evaluate(Activation& a) const = 0;
+};
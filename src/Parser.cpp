@@ -24,7 +24,9 @@
 #include "Parser.h"
 #include "Context.h"
 #include "IteratorRange.h"
+#include "InterpreterExceptions.h"
 #include "ParseExceptions.h"
+#include "SymbolTable.h"
 #include "bigint/BigIntegerLibrary.h"
 #include <algorithm>
 #include <boost/algorithm/string.hpp>
@@ -58,13 +60,15 @@ Cell Parser::parse_cell(string program) {
 
     c.set_type(is_literal(program) ? Cell::Literal : Cell::Symbol);
 
-    if (c.is_literal()) {
+    if (c.type() == Cell::Symbol) {
+      c.set_symbol(SymbolTable::intern(program));
+    } else {
       if (is_bool(program)) {
-        c.set_literal_type("bool");
+        c.set_literal_type(LiteralType::boolean());
       } else if (is_string(program)) {
-        c.set_literal_type("string");
+        c.set_literal_type(LiteralType::string());
       } else if (is_integer(program)) {
-        c.set_literal_type("int");
+        c.set_literal_type(LiteralType::integer());
       }
     }
 
@@ -79,11 +83,11 @@ Cell Parser::parse_cell(string program) {
       arguments.emplace_back(parse_cell(part));
     }
 
-    c.set_args(arguments);
+    c.set_args(move(arguments));
     c.set_type(Cell::List);
   }
 
-  return (c);
+  return c;
 }
 
 void Parser::normalize(string& s) {
@@ -157,7 +161,7 @@ bool Parser::is_keyword(const string& k) {
 }
 
 bool Parser::is_existing_symbol(const string& k) {
-  return Context::global_context()->has_symbol(k);
+  return Context::global_context()->has_symbol(SymbolTable::intern(k));
 }
 
 void Parser::remove_empty_parts(vector<string>& parts) {
@@ -177,3 +181,37 @@ pair<string, string> Parser::parse_value_and_type(const string& program) {
   }
   return make_pair(parts[0], parts[1]);
 }
+
+void Parser::parse_lambda(Cell& c) {
+  c.set_type(Cell::Lambda);
+  auto lambda_return_type = parse_value_and_type(c.arg(0).value());
+  if (not(boost::starts_with(lambda_return_type.first, "lambda")))
+    throw InterpreterException::undefined();
+
+  vector<const LiteralType*> parameters;
+  for (auto& a : c.arg(1).args()) {
+    auto value_type = parse_value_and_type(a.value());
+    a.set_value(value_type.first);
+    a.set_literal_type(LiteralType::parse(value_type.second));
+    parameters.push_back(a.literal_type());
+  }
+
+  c.set_literal_type(LiteralType::function(
+      parameters, LiteralType::parse(lambda_return_type.second)));
+  c.arg(0).set_value("lambda:" + c.literal_type()->to_string());
+  c.arg(0).set_literal_type(c.literal_type());
+  /* What printing the lambda shows: its text before the lambdas inside it
+   * are parsed. */
+  c.set_value(c.to_string());
+}
+
+void Parser::parse_lambdas(Cell& c) {
+  if (c.is_value()) return;
+  /* Lambdas of the wrong arity are left for the TypeChecker to report. */
+  if (c.arg(0).type() == Cell::Symbol and boost::starts_with(c.arg(0).value(), "lambda")) {
+    if (c.arity() != 3) return;
+    parse_lambda(c);
+    return parse_lambdas(c.arg(2));
+  }
+  for (auto& a : c.args()) parse_lambdas(a);
+}
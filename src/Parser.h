@@ -35,7 +35,15 @@ public:
   static std::pair<std::string, std::string>
   parse_value_and_type(const std::string& program);
 
+  /* Parses the annotations of every well-formed lambda in c, once, for
+   * every later pass to read from the Cells. */
+  static void parse_lambdas(Cell& c);
+
 private:
+  /* Splits the annotations of a lambda:type (p:type ...) body form into
+   * names and types, and gives the lambda its literal type. */
+  static void parse_lambda(Cell& c);
+
   static Cell parse_cell(std::string program);
 
   static void normalize(std::string& s);
@@ -0,0 +1,237 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "Resolver.h"
+#include "Cell.h"
+#include "SymbolTable.h"
+
+#include <cassert>
+#include <ciso646>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+using namespace std;
+
+void Resolver::resolve(Cell& c) {
+	Resolver resolver;
+	resolver.resolve_expression(c);
+}
+
+void Resolver::resolve_expression(Cell& c) {
+	if (c.is_value()) {
+		if (c.type() == Cell::Symbol) 
+			resolve_symbol(c);
+		return;
+	}
+
+	/* Ill-formed special forms are left alone; the interpreter reports
+	 * their arity errors. */
+	auto form = special_form(c);
+	if (form == "lambda") {
+		if (c.arity() == 3) resolve_lambda(c);
+	} else if (form == "define") {
+		if (c.arity() == 3) resolve_define(c);
+	} else if (form == "local") {
+		if (c.arity() == 3) resolve_local(c);
+	} else if (form == "if" or form == "begin") {
+		for (int i = 1; i < c.arity(); ++i) 
+			resolve_expression(c.arg(i));
+	} else {
+		for (auto& a : c.args()) 
+			resolve_expression(a);
+	}
+}
+
+void Resolver::resolve_symbol(Cell& c) {
+	for (int i = scopes_.size() - 1; i >= 0; --i) {
+		const auto& scope = scopes_[i];
+		int found = find(c.symbol(), scope);
+		if (found < 0) 
+			continue;
+
+		Variable variable(scope.function, scope.slots[found]);
+		int innermost = functions_.size() - 1;
+		if (variable.first == innermost) {
+			c.set_location(Cell::Slot, variable.second);
+		} else {
+			c.set_location(Cell::Captured, capture(innermost, variable));
+		}
+		use(variable, c);
+		return;
+	}
+	c.set_location(Cell::Global, -1);
+}
+
+void Resolver::resolve_lambda(Cell& c) {
+	open_function(c);
+	Scope scope{(int)functions_.size() - 1, {}, {}};
+	for (const auto& a : c.arg(1).args()) 
+		declare(SymbolTable::intern(a.value()), scope);
+	declare_definitions(c.arg(2), scope);
+
+	scopes_.push_back(move(scope));
+	resolve_expression(c.arg(2));
+	scopes_.pop_back();
+	close_function();
+}
+
+void Resolver::resolve_define(Cell& c) {
+	auto& name = c.arg(1);
+	name.set_symbol(SymbolTable::intern(name.value()));
+	if (scopes_.empty()) {
+		name.set_location(Cell::Global, -1);
+	} else {
+		/* Definitions always bind in the innermost scope. */
+		const auto& scope = scopes_.back();
+		int found = find(name.symbol(), scope);
+		assert(found >= 0);
+		Variable variable(scope.function, scope.slots[found]);
+		name.set_location(Cell::Slot, variable.second);
+		functions_[variable.first].defined[variable.second] = true;
+		use(variable, name);
+	}
+	resolve_expression(c.arg(2));
+}
+
+void Resolver::resolve_local(Cell& c) {
+	/* Local blocks inside lambdas share their frame. */
+	bool opens_frame = functions_.empty();
+	if (opens_frame) 
+		open_function(c);
+
+	Scope scope{(int)functions_.size() - 1, {}, {}};
+	for (const auto& a : c.arg(1).args()) 
+		declare_definitions(a, scope);
+	declare_definitions(c.arg(2), scope);
+
+	scopes_.push_back(move(scope));
+	for (auto& a : c.arg(1).args()) 
+		resolve_expression(a);
+	resolve_expression(c.arg(2));
+	scopes_.pop_back();
+
+	if (opens_frame) {
+		close_function();
+	} else {
+		c.set_frame_size(0);
+		c.set_boxes({});
+	}
+}
+
+void Resolver::open_function(Cell& c) {
+	functions_.emplace_back();
+	functions_.back().cell = &c;
+}
+
+void Resolver::close_function() {
+	auto& function = functions_.back();
+	vector<int> boxes;
+	for (int slot = 0; slot < function.frame_size; ++slot) {
+		bool boxed = function.captured[slot] and function.defined[slot];
+		if (boxed) 
+			boxes.push_back(slot);
+		for (auto* c : function.uses[slot]) 
+			c->set_boxed(boxed);
+	}
+
+	auto& c = *function.cell;
+	c.set_frame_size(function.frame_size);
+	c.set_boxes(move(boxes));
+	c.set_captures(move(function.captures));
+	functions_.pop_back();
+}
+
+void Resolver::declare(int symbol, Scope& scope) {
+	auto& function = functions_[scope.function];
+	scope.symbols.push_back(symbol);
+	scope.slots.push_back(function.frame_size++);
+	function.captured.push_back(false);
+	function.defined.push_back(false);
+	function.uses.emplace_back();
+}
+
+void Resolver::declare_definitions(const Cell& c, Scope& scope) {
+	if (c.is_value()) 
+		return;
+
+	/* Nested lambdas and locals open frames of their own. */
+	auto form = special_form(c);
+	if (form == "lambda" or form == "local") 
+		return;
+
+	if (form == "define" and c.arity() == 3) {
+		int symbol = SymbolTable::intern(c.arg(1).value());
+		if (find(symbol, scope) < 0) 
+			declare(symbol, scope);
+	}
+
+	for (const auto& a : c.args()) 
+		declare_definitions(a, scope);
+}
+
+int Resolver::capture(int function, Variable variable) {
+	auto& captured = functions_[function].captured_variables;
+	for (int i = 0; i < (int)captured.size(); ++i) {
+		if (captured[i] == variable) 
+			return i;
+	}
+
+	/* Taken from the frame the lambda is evaluated in: either that is where
+	 * the variable lives, or that frame's lambda captures it too. */
+	Cell::Capture from;
+	if (function - 1 == variable.first) {
+		from = Cell::Capture{Cell::Slot, variable.second};
+		functions_[variable.first].captured[variable.second] = true;
+	} else {
+		from = Cell::Capture{Cell::Captured, capture(function - 1, variable)};
+	}
+	functions_[function].captures.push_back(from);
+	captured.push_back(variable);
+	return captured.size() - 1;
+}
+
+void Resolver::use(Variable variable, Cell& c) {
+	functions_[variable.first].uses[variable.second].push_back(&c);
+}
+
+int Resolver::find(int symbol, const Scope& scope) {
+	/* Search backwards so that a repeated parameter name refers to the last
+	 * occurrence, as it did when frames were maps. */
+	for (int i = scope.symbols.size() - 1; i >= 0; --i) {
+		if (scope.symbols[i] == symbol) 
+			return i;
+	}
+	return -1;
+}
+
+string Resolver::special_form(const Cell& c) {
+	if (c.arity() == 0 or c.arg(0).type() != Cell::Symbol) 
+		return "";
+	const auto& first_argument = c.arg(0).value();
+	if (boost::starts_with(first_argument, "lambda")) 
+		return "lambda";
+	if (first_argument == "define" or first_argument == "if" or
+		first_argument == "local" or first_argument == "begin")
+		return first_argument;
+	return "";
+}
@@ -0,0 +1,115 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "Cell.h"
+
+/* Pass run over each top-level form before it is interpreted. It lays out
+ * the frame of every lambda (parameters first, then the names defined
+ * directly inside it or in its local blocks) and annotates each symbol with
+ * where it lives, so variable lookup never has to hash an identifier.
+ * Symbols not bound by any enclosing lambda or local block are left as
+ * globals.
+ *
+ * It also finds the free variables of each lambda: those bound in an
+ * enclosing frame. A lambda captures exactly those, along with the ones
+ * the lambdas inside it need, so closures don't keep whole frames alive. */
+class Resolver {
+public:
+	static void resolve(Cell& c);
+
+private:
+	/* A variable: the index of the function whose frame it lives in, and
+	 * its slot there. */
+	typedef std::pair<int, int> Variable;
+
+	/* A lambda, or a local block outside any lambda: something that opens a
+	 * frame at run time. */
+	struct Function {
+		Cell* cell;
+
+		int frame_size = 0;
+
+		std::vector<Cell::Capture> captures;
+
+		/* What each capture stands for. */
+		std::vector<Variable> captured_variables;
+
+		/* Per slot: whether a lambda inside captures it, whether it is
+		 * defined, and the cells that use it. */
+		std::vector<bool> captured;
+
+		std::vector<bool> defined;
+
+		std::vector<std::vector<Cell*>> uses;
+	};
+
+	/* The names bound by a lambda or local block, indexed like slots, and
+	 * where each lives in the frame of function. */
+	struct Scope {
+		int function;
+
+		std::vector<int> symbols;
+
+		std::vector<int> slots;
+	};
+
+	void resolve_expression(Cell& c);
+
+	void resolve_symbol(Cell& c);
+
+	void resolve_lambda(Cell& c);
+
+	void resolve_define(Cell& c);
+
+	void resolve_local(Cell& c);
+
+	void open_function(Cell& c);
+
+	/* Lays out the frame of the innermost function once its whole body is
+	 * resolved, boxing the variables that are both captured and defined. */
+	void close_function();
+
+	/* Gives symbol a new slot in the frame of scope's function. */
+	void declare(int symbol, Scope& scope);
+
+	void declare_definitions(const Cell& c, Scope& scope);
+
+	/* Index of variable among the captures of function, which captures it
+	 * (and so do the functions between them) if it doesn't yet. */
+	int capture(int function, Variable variable);
+
+	void use(Variable variable, Cell& c);
+
+	static int find(int symbol, const Scope& scope);
+
+	static std::string special_form(const Cell& c);
+
+	std::vector<Function> functions_;
+
+	std::vector<Scope> scopes_;
+};
@@ -0,0 +1,390 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "TypeChecker.h"
+#include "BuiltIns.h"
+#include "Cell.h"
+#include "InterpreterExceptions.h"
+#include "SymbolTable.h"
+#include "Validator.h"
+
+#include <ciso646>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+using namespace std;
+
+TypeChecker::TypeChecker() {
+	for (const auto& b : BuiltIns::get()) {
+		builtins_[SymbolTable::intern(b.first)] = b.second.literal_type();
+	}
+}
+
+void TypeChecker::check(const Cell& c) {
+	auto globals = globals_;
+	frames_.clear();
+	trail_.clear();
+	try {
+		check_expression(c);
+	} catch (...) {
+		for (auto& variable : trail_) 
+			variable->binding.reset();
+		globals_ = move(globals);
+		throw;
+	}
+	trail_.clear();
+}
+
+TypeChecker::TypePtr TypeChecker::check_expression(const Cell& c) {
+	/* () has no arguments, like a value, but evaluates to empty. */
+	if (c.type() == Cell::List and c.arity() == 0) {
+		return make(Type::List, {make(Type::Variable)});
+	}
+
+	if (c.is_value()) {
+		return (c.type() == Cell::Symbol) ? check_symbol(c) 
+			: import(c.literal_type());
+	}
+
+	if (c.arg(0).type() == Cell::Symbol) {
+		const auto& first_argument = c.arg(0).value();
+
+		if (boost::starts_with(first_argument, "lambda")) {
+			return check_lambda(c);
+		} else if (first_argument == "define") {
+			return check_define(c);
+		} else if (first_argument == "if") {
+			return check_if(c);
+		} else if (first_argument == "local") {
+			return check_local(c);
+		} else if (first_argument == "begin") {
+			return check_begin(c);
+		}
+	}
+
+	return check_call(c);
+}
+
+TypeChecker::TypePtr TypeChecker::check_symbol(const Cell& c) {
+	if (c.location() == Cell::Slot) {
+		return frames_.back().slots[c.index()];
+	} else if (c.location() == Cell::Captured) {
+		return frames_.back().captures[c.index()];
+	}
+
+	auto builtin = builtins_.find(c.symbol());
+	if (builtin != builtins_.end()) {
+		return import(builtin->second);
+	}
+
+	auto& t = globals_[c.symbol()];
+	if (not t) {
+		/* Used before being defined: whatever the uses require of it, its
+		 * definition will have to provide. */
+		t = make(Type::Variable);
+	}
+	return t;
+}
+
+TypeChecker::TypePtr TypeChecker::check_lambda(const Cell& c) {
+	Validator::assert_arity("lambda", 2, c.args().size() - 1);
+
+	/* The Parser has already read the annotations into the lambda's type. */
+	const auto* annotation = c.literal_type();
+	unordered_map<const LiteralType*, TypePtr> variables;
+	auto return_type = import(annotation->result(), variables);
+
+	Frame frame;
+	for (int i = 0; i < annotation->arity(); ++i) 
+		frame.slots.push_back(import(annotation->parameter(i), variables));
+	auto type = make(Type::Function, frame.slots);
+	type->arguments.push_back(return_type);
+
+	/* The rest of the frame holds the names defined in the body. */
+	while ((int)frame.slots.size() < c.frame_size()) {
+		frame.slots.push_back(make(Type::Variable));
+	}
+	/* Captures have the type of what they capture. */
+	for (const auto& capture : c.captures()) {
+		const auto& outer = frames_.back();
+		frame.captures.push_back(capture.location == Cell::Slot 
+			? outer.slots[capture.index] : outer.captures[capture.index]);
+	}
+	frames_.push_back(move(frame));
+	auto body = check_expression(c.arg(2));
+	frames_.pop_back();
+
+	if (not unify(return_type, body)) {
+		throw InterpreterException("Error: lambda:" + to_string(type) 
+			+ " must return " + to_string(return_type) + ", given " 
+			+ to_string(body) + ".");
+	}
+	return type;
+}
+
+TypeChecker::TypePtr TypeChecker::check_define(const Cell& c) {
+	Validator::assert_arity("define", 2, c.args().size() - 1);
+
+	const auto& name = c.arg(1);
+	if (name.type() != Cell::Symbol) {
+		throw InterpreterException("Error: define expects a name, given " 
+			+ name.to_string() + ".");
+	}
+
+	TypePtr declared;
+	if (name.is_global()) {
+		if (builtins_.count(name.symbol())) {
+			throw InterpreterException("Error: " + name.value() 
+				+ " is a built-in and can't be redefined.");
+		}
+		auto& t = globals_[name.symbol()];
+		if (not t) {
+			/* Declared ahead of the value, so that it may refer to itself. */
+			t = make(Type::Variable);
+		}
+		declared = t;
+	} else {
+		declared = frames_.back().slots[name.index()];
+	}
+
+	auto value = check_expression(c.arg(2));
+	if (not unify(declared, value)) {
+		throw InterpreterException("Error: " + name.value() + " is defined as " 
+			+ to_string(declared) + ", given " + to_string(value) + ".");
+	}
+	return value;
+}
+
+TypeChecker::TypePtr TypeChecker::check_if(const Cell& c) {
+	Validator::assert_arity("if", 3, c.args().size() - 1);
+
+	auto test = check_expression(c.arg(1));
+	if (not unify(make(Type::Bool), test)) {
+		throw TypeException("if's test", "bool", to_string(test));
+	}
+
+	auto consequent = check_expression(c.arg(2));
+	auto alternative = check_expression(c.arg(3));
+	if (not unify(consequent, alternative)) {
+		throw InterpreterException("Error: if's branches must have the same "
+			"type, given " + to_string(consequent) + " and " 
+			+ to_string(alternative) + ".");
+	}
+	return consequent;
+}
+
+TypeChecker::TypePtr TypeChecker::check_local(const Cell& c) {
+	Validator::assert_arity("local", 2, c.args().size() - 1);
+
+	/* Only blocks outside of any lambda have a frame of their own; the
+	 * others' names are in the frame of the lambda around them. */
+	bool opens_frame = c.frame_size() > 0;
+	if (opens_frame) {
+		Frame frame;
+		for (int i = 0; i < c.frame_size(); ++i) {
+			frame.slots.push_back(make(Type::Variable));
+		}
+		frames_.push_back(move(frame));
+	}
+	for (const auto& command : c.arg(1).args()) {
+		check_expression(command);
+	}
+	auto body = check_expression(c.arg(2));
+	if (opens_frame) {
+		frames_.pop_back();
+	}
+	return body;
+}
+
+TypeChecker::TypePtr TypeChecker::check_begin(const Cell& c) {
+	if (c.arity() == 1) {
+		throw InterpreterException("Error: begin expects at least 1 "
+			"arguments, given 0.");
+	}
+	TypePtr last;
+	for (int i = 1; i < c.arity(); ++i) {
+		last = check_expression(c.arg(i));
+	}
+	return last;
+}
+
+TypeChecker::TypePtr TypeChecker::check_call(const Cell& c) {
+	auto procedure = resolve(check_expression(c.arg(0)));
+	vector<TypePtr> args;
+	for (int i = 1; i < c.arity(); ++i) {
+		args.push_back(check_expression(c.arg(i)));
+	}
+	auto name = c.arg(0).to_string();
+
+	if (procedure->kind == Type::Variable) {
+		auto result = make(Type::Variable);
+		auto expected = make(Type::Function, args);
+		expected->arguments.push_back(result);
+		if (not unify(procedure, expected)) {
+			throw TypeException(name, to_string(expected), to_string(procedure));
+		}
+		return result;
+	}
+
+	if (procedure->kind != Type::Function) {
+		throw InterpreterException("Undefined procedure: " + name + ".");
+	}
+
+	if (procedure->variadic) {
+		for (const auto& a : args) {
+			if (not unify(procedure->arguments[0], a)) {
+				throw InterpreterException("Error: a list must have all "
+					"arguments of the same type");
+			}
+		}
+		return procedure->arguments[1];
+	}
+
+	int arity = procedure->arguments.size() - 1;
+	Validator::assert_arity(name, arity, args.size());
+	for (int i = 0; i < arity; ++i) {
+		if (not unify(procedure->arguments[i], args[i])) {
+			throw TypeException(name, to_string(procedure->arguments[i]), 
+				to_string(args[i]));
+		}
+	}
+	return procedure->arguments.back();
+}
+
+bool TypeChecker::unify(TypePtr a, TypePtr b) {
+	a = resolve(a);
+	b = resolve(b);
+	if (a == b) return true;
+
+	if (a->kind == Type::Variable) {
+		if (occurs(a.get(), b)) return false;
+		a->binding = b;
+		trail_.push_back(a);
+		return true;
+	}
+	if (b->kind == Type::Variable) return unify(b, a);
+	if (a->kind != b->kind) return false;
+
+	if (a->kind == Type::Function and a->variadic != b->variadic) {
+		if (a->variadic) swap(a, b);
+		/* b takes any number of arguments; a names how many. */
+		for (size_t i = 0; i + 1 < a->arguments.size(); ++i) {
+			if (not unify(a->arguments[i], b->arguments[0])) return false;
+		}
+		return unify(a->arguments.back(), b->arguments.back());
+	}
+
+	if (a->arguments.size() != b->arguments.size()) return false;
+	for (size_t i = 0; i < a->arguments.size(); ++i) {
+		if (not unify(a->arguments[i], b->arguments[i])) return false;
+	}
+	return true;
+}
+
+bool TypeChecker::occurs(const Type* variable, TypePtr t) {
+	t = resolve(t);
+	if (t.get() == variable) return true;
+	for (const auto& a : t->arguments) {
+		if (occurs(variable, a)) return true;
+	}
+	return false;
+}
+
+TypeChecker::TypePtr TypeChecker::resolve(TypePtr t) {
+	while (t->kind == Type::Variable and t->binding) {
+		t = t->binding;
+	}
+	return t;
+}
+
+TypeChecker::TypePtr TypeChecker::make(Type::Kind kind, 
+									   vector<TypePtr> arguments) {
+	auto t = make_shared<Type>();
+	t->kind = kind;
+	t->arguments = move(arguments);
+	return t;
+}
+
+TypeChecker::TypePtr TypeChecker::import(const LiteralType* t,
+	unordered_map<const LiteralType*, TypePtr>& variables) {
+	switch (t->kind()) {
+	case LiteralType::Int:
+		return make(Type::Int);
+	case LiteralType::Bool:
+		return make(Type::Bool);
+	case LiteralType::String:
+		return make(Type::String);
+	case LiteralType::List:
+		return make(Type::List, {t->element() 
+			? import(t->element(), variables) : make(Type::Variable)});
+	case LiteralType::Variable: {
+		auto& v = variables[t];
+		if (not v) v = make(Type::Variable);
+		return v;
+	}
+	case LiteralType::Function:
+		break;
+	}
+
+	auto f = make(Type::Function);
+	f->variadic = t->is_variadic();
+	for (int i = 0; i < t->arity(); ++i) {
+		f->arguments.push_back(import(t->parameter(i), variables));
+	}
+	f->arguments.push_back(import(t->result(), variables));
+	return f;
+}
+
+TypeChecker::TypePtr TypeChecker::import(const LiteralType* t) {
+	unordered_map<const LiteralType*, TypePtr> variables;
+	return import(t, variables);
+}
+
+const LiteralType* TypeChecker::describe(TypePtr t) {
+	t = resolve(t);
+	switch (t->kind) {
+	case Type::Int:
+		return LiteralType::integer();
+	case Type::Bool:
+		return LiteralType::boolean();
+	case Type::String:
+		return LiteralType::string();
+	case Type::List:
+		return LiteralType::list(describe(t->arguments[0]));
+	case Type::Variable:
+		return LiteralType::variable('x');
+	case Type::Function:
+		break;
+	}
+
+	vector<const LiteralType*> parameters;
+	for (size_t i = 0; i + 1 < t->arguments.size(); ++i) {
+		parameters.push_back(describe(t->arguments[i]));
+	}
+	return LiteralType::function(parameters, describe(t->arguments.back()),
+		t->variadic);
+}
+
+const string& TypeChecker::to_string(TypePtr t) {
+	return describe(t)->to_string();
+}
@@ -0,0 +1,125 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LiteralType.h"
+
+class Cell;
+
+/* Checks every top-level form against the lambda:type and name:type
+ * annotations before it runs, so that neither evaluator needs to validate
+ * arities or types at run time. 
+ *
+ * Annotated lambdas have monomorphic types; type variables only stand for
+ * what annotations leave open: the element type of empty, the x of
+ * polymorphic built-ins, and names used before they are defined (as in
+ * mutually recursive functions), which are settled by unification. */
+class TypeChecker {
+public:
+	TypeChecker();
+
+	/* Checks a resolved top-level form. If it is ill-typed, throws and
+	 * leaves the global bindings as they were. */
+	void check(const Cell& c);
+
+private:
+	struct Type;
+
+	typedef std::shared_ptr<Type> TypePtr;
+
+	struct Type {
+		enum Kind { Int, Bool, String, List, Function, Variable };
+
+		Kind kind;
+
+		/* The element of a List; the parameters and then the result of a
+		 * Function. */
+		std::vector<TypePtr> arguments;
+
+		/* A Function taking any number of arguments of its one parameter
+		 * type. */
+		bool variadic = false;
+
+		/* What unification bound a Variable to. */
+		TypePtr binding;
+	};
+
+	TypePtr check_expression(const Cell& c);
+
+	TypePtr check_symbol(const Cell& c);
+
+	TypePtr check_lambda(const Cell& c);
+
+	TypePtr check_define(const Cell& c);
+
+	TypePtr check_if(const Cell& c);
+
+	TypePtr check_local(const Cell& c);
+
+	TypePtr check_begin(const Cell& c);
+
+	TypePtr check_call(const Cell& c);
+
+	bool unify(TypePtr a, TypePtr b);
+
+	bool occurs(const Type* variable, TypePtr t);
+
+	static TypePtr resolve(TypePtr t);
+
+	static TypePtr make(Type::Kind kind, std::vector<TypePtr> arguments = {});
+
+	/* Makes a term of t, with a fresh variable for each of its type
+	 * variables and for the element type of empty. */
+	static TypePtr import(const LiteralType* t,
+		std::unordered_map<const LiteralType*, TypePtr>& variables);
+
+	static TypePtr import(const LiteralType* t);
+
+	/* The LiteralType t currently stands for; unbound variables become x. */
+	static const LiteralType* describe(TypePtr t);
+
+	static const std::string& to_string(TypePtr t);
+
+	/* Built-ins are polymorphic: each use imports their type afresh. */
+	std::unordered_map<int, const LiteralType*> builtins_;
+
+	std::unordered_map<int, TypePtr> globals_;
+
+	/* Types of the slots and captures of a frame. */
+	struct Frame {
+		std::vector<TypePtr> slots;
+
+		std::vector<TypePtr> captures;
+	};
+
+	/* The enclosing frames, innermost last. */
+	std::vector<Frame> frames_;
+
+	/* Variables bound while checking the current form. */
+	std::vector<TypePtr> trail_;
+};
@@ -39,27 +39,3 @@ void Validator::assert_arity(const std::string& function_name,
 		throw ArityException(function_name, expected_arity, given_arity);
 	}
 }
-
-void Validator::assert_arity(const string& function_name,
-							 int expected_arity, const Cells& args) {
-	assert_arity(function_name, expected_arity, args.size());
-}
-
-void Validator::assert_type(const string& function_name,
-							const string& expected_type, const Cell& c) {
-	if (expected_type.size() >= 2 and expected_type.front() == '['
-		and expected_type.back() == ']' and c.is_empty()) {
-		return;
-	}
-	if (c.literal_type() != expected_type) {
-		throw TypeException(function_name, expected_type, c.literal_type());
-	}
-}
-
-void Validator::assert_list_type(const Cell& new_element, const Cells& list) {
-	if (not all_of(begin(list), end(list), [&](const Cell& c) {
-		return c.literal_type() == new_element.literal_type(); })) {
-		throw InterpreterException("Error: a list must have all arguments "
-			"of the same type");
-	}
-}
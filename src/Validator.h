@@ -23,21 +23,11 @@
 */
 #pragma once
 
-#include "Cell.h"
-
 #include <string>
 
 class Validator {
 public:	
 	static void assert_arity(const std::string& function_name,
 		int expected_arity, int given_arity);
-
-	static void assert_arity(const std::string& function_name,
-		int expected_arity, const Cells& args);
-
-	static void assert_type(const std::string& function_name,
-		const std::string& expected_type, const Cell& c);
-
-	static void assert_list_type(const Cell& new_element, const Cells& list);
 };
 
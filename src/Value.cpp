@@ -0,0 +1,385 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2013 Alex Gliesch
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "Value.h"
+#include "Function.h"
+#include "bigint/BigIntegerLibrary.h"
+#include <boost/algorithm/string/predicate.hpp>
+#include <algorithm>
+#include <ciso646>
+#include <climits>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+/* The most recently made live box, heading the list of all of them. */
+BoxObject* boxes = nullptr;
+
+/* How many more boxes to make before looking for cycles. Collecting costs
+ * as much as the values reachable from boxes, so it waits for at least as
+ * many boxes as there were such values left live the last time. */
+const size_t min_collection_interval = 4096;
+
+size_t boxes_until_collection = min_collection_interval;
+
+/* Parses a decimal literal into an int64_t, failing instead of overflowing so
+ * that the caller can fall back to BigInteger. */
+bool parse_int64(const std::string& s, int64_t& result) {
+  size_t i = (not s.empty() and (s[0] == '-' or s[0] == '+')) ? 1 : 0;
+  if (i == s.size()) return false;
+  bool negative = s[0] == '-';
+  int64_t n = 0;
+  for (; i < s.size(); ++i) {
+    if (s[i] < '0' or s[i] > '9') return false;
+    int digit = s[i] - '0';
+    if (__builtin_mul_overflow(n, 10, &n) or
+        __builtin_add_overflow(n, negative ? -digit : digit, &n)) {
+      return false;
+    }
+  }
+  result = n;
+  return true;
+}
+} // namespace
+
+Value::Value(Type type, HeapObject* object) : type_(type), object_(object) {
+  retain();
+}
+
+Value& Value::operator=(const Value& v) {
+  if (this != &v) {
+    Value copy(v);
+    *this = move(copy);
+  }
+  return *this;
+}
+
+Value& Value::operator=(Value&& v) noexcept {
+  if (this != &v) {
+    release();
+    type_ = v.type_;
+    int_ = v.int_;
+    v.type_ = Empty;
+  }
+  return *this;
+}
+
+Value Value::undefined() {
+  Value v;
+  v.type_ = Undefined;
+  return v;
+}
+
+Value Value::boolean(bool b) {
+  Value v;
+  v.type_ = Bool;
+  v.bool_ = b;
+  return v;
+}
+
+Value Value::integer(int64_t i) {
+  Value v;
+  v.type_ = Int;
+  v.int_ = i;
+  return v;
+}
+
+Value Value::integer(BigInteger i) {
+  /* Keep the number immediate whenever it fits in an int64_t. */
+  const auto& mag = i.getMagnitude();
+  if (mag.getLength() <= 1) {
+    auto block = mag.getBlock(0);
+    if (block <= BigUnsigned::Blk(INT64_MAX)) {
+      auto magnitude = int64_t(block);
+      return integer(i.getSign() == BigInteger::negative ? -magnitude : magnitude);
+    }
+    if (i.getSign() == BigInteger::negative and
+        block == BigUnsigned::Blk(INT64_MAX) + 1) {
+      return integer(INT64_MIN);
+    }
+  }
+  return Value(BigInt, new BigIntObject(move(i)));
+}
+
+Value Value::string(const std::string& s) { return Value(String, new StringObject(s)); }
+
+Value Value::cons(Value first, Value rest, const LiteralType* literal_type) {
+  return Value(List, new ListObject(move(first), move(rest), literal_type));
+}
+
+Value Value::list(const Values& elements, const LiteralType* literal_type) {
+  Value list;
+  for (auto it = elements.rbegin(); it != elements.rend(); ++it) {
+    list = cons(*it, move(list), literal_type);
+  }
+  return list;
+}
+
+Value Value::lambda(shared_ptr<const Cell> lambda, Values captures) {
+  return Value(Lambda, new LambdaObject(move(lambda), move(captures)));
+}
+
+Value Value::closure(shared_ptr<const Function> function, Values captures) {
+  return Value(Closure, new ClosureObject(move(function), move(captures)));
+}
+
+Value Value::builtin(BuiltinProcedure procedure, const std::string& name,
+                     const LiteralType* literal_type) {
+  return Value(BuiltInProcedure, new BuiltInObject(move(procedure), name, literal_type));
+}
+
+Value Value::literal(const Cell& c) {
+  const auto* type = c.literal_type();
+  if (type == LiteralType::integer()) {
+    int64_t i;
+    if (parse_int64(c.value(), i)) return integer(i);
+    return integer(stringToBigInteger(c.value()));
+  } else if (type == LiteralType::boolean()) {
+    return boolean(boost::iequals(c.value(), "true"));
+  } else {
+    return string(c.value());
+  }
+}
+
+Value Value::box(Value contents) {
+  if (--boxes_until_collection == 0) collect_cycles();
+  return Value(Box, new BoxObject(move(contents)));
+}
+
+BoxObject::BoxObject(Value contents)
+    : contents(move(contents)), previous(nullptr), next(boxes) {
+  if (next) next->previous = this;
+  boxes = this;
+}
+
+BoxObject::~BoxObject() {
+  (previous ? previous->next : boxes) = next;
+  if (next) next->previous = previous;
+}
+
+template <class F>
+void Value::for_each_reference(Type type, HeapObject* object, F f) {
+  switch (type) {
+  case List:
+    f(static_cast<ListObject*>(object)->first);
+    f(static_cast<ListObject*>(object)->rest);
+    break;
+  case Lambda:
+    for (const auto& v : static_cast<LambdaObject*>(object)->captures) f(v);
+    break;
+  case Closure:
+    for (const auto& v : static_cast<ClosureObject*>(object)->captures) f(v);
+    break;
+  case Box:
+    f(static_cast<BoxObject*>(object)->contents);
+    break;
+  default:
+    break;
+  }
+}
+
+void Value::collect_cycles() {
+  /* Trial deletion, over the values reachable from boxes: only a box can
+   * come to refer to something made after it, so every cycle goes through
+   * one. Taking the references among those values away from their counts
+   * leaves the ones referred to from elsewhere, such as frames or globals.
+   * What they reach is live, and the boxes left refer to each other only. */
+  struct Node {
+    Type type;
+    int outside;
+    bool live;
+  };
+  unordered_map<HeapObject*, Node> nodes;
+  vector<HeapObject*> pending;
+  auto discover = [&](Type type, HeapObject* object) {
+    if (nodes.emplace(object, Node{type, object->references_, false}).second) {
+      pending.push_back(object);
+    }
+  };
+  for (auto* b = boxes; b; b = b->next) discover(Box, b);
+  while (not pending.empty()) {
+    auto* object = pending.back();
+    pending.pop_back();
+    for_each_reference(nodes[object].type, object, [&](const Value& v) {
+      if (v.is_heap()) discover(v.type_, v.object_);
+    });
+  }
+
+  for (auto& n : nodes) {
+    for_each_reference(n.second.type, n.first, [&](const Value& v) {
+      if (v.is_heap()) --nodes[v.object_].outside;
+    });
+  }
+
+  auto mark = [&](const Value& v) {
+    if (not v.is_heap()) return;
+    auto& n = nodes[v.object_];
+    if (not n.live) {
+      n.live = true;
+      pending.push_back(v.object_);
+    }
+  };
+  for (auto& n : nodes) {
+    if (n.second.outside > 0 and not n.second.live) {
+      n.second.live = true;
+      pending.push_back(n.first);
+    }
+  }
+  while (not pending.empty()) {
+    auto* object = pending.back();
+    pending.pop_back();
+    for_each_reference(nodes[object].type, object, mark);
+  }
+
+  /* Hold the garbage boxes while emptying them, since emptying one may
+   * free the others. */
+  Values garbage;
+  size_t live = 0;
+  for (auto& n : nodes) {
+    if (n.second.live) {
+      ++live;
+    } else if (n.second.type == Box) {
+      garbage.push_back(Value(Box, n.first));
+    }
+  }
+  for (auto& b : garbage) b.set_contents(Value());
+
+  boxes_until_collection = max(min_collection_interval, live);
+}
+
+void Value::destroy() {
+  if (type_ != List) {
+    delete object_;
+    return;
+  }
+  /* Free a list node by node, so that dropping a long list doesn't recurse
+   * once per element. Stop at the first node still shared with someone. */
+  auto* node = static_cast<ListObject*>(object_);
+  Value rest = move(node->rest);
+  delete node;
+  while (rest.type_ == List and rest.object_->references_ == 1) {
+    Value next = move(static_cast<ListObject*>(rest.object_)->rest);
+    rest = move(next);
+  }
+}
+
+BigInteger Value::as_big_integer() const {
+  if (type_ == BigInt) return static_cast<const BigIntObject*>(object_)->value;
+  if (int_ >= 0) return BigInteger(long(int_));
+  /* Negate in unsigned arithmetic so that INT64_MIN survives. */
+  return BigInteger(BigUnsigned(0ul - (unsigned long)int_), BigInteger::negative);
+}
+
+const std::string& Value::as_string() const {
+  return static_cast<const StringObject*>(object_)->value;
+}
+
+const Value& Value::first() const { return static_cast<const ListObject*>(object_)->first; }
+
+const Value& Value::rest() const { return static_cast<const ListObject*>(object_)->rest; }
+
+const Cell& Value::lambda() const { return *static_cast<const LambdaObject*>(object_)->lambda; }
+
+const shared_ptr<const Cell>& Value::shared_lambda() const {
+  return static_cast<const LambdaObject*>(object_)->lambda;
+}
+
+const Function& Value::function() const {
+  return *static_cast<const ClosureObject*>(object_)->function;
+}
+
+const Values& Value::captures() const {
+  if (type_ == Closure) return static_cast<const ClosureObject*>(object_)->captures;
+  return static_cast<const LambdaObject*>(object_)->captures;
+}
+
+const Value& Value::contents() const { return static_cast<const BoxObject*>(object_)->contents; }
+
+void Value::set_contents(Value contents) {
+  static_cast<BoxObject*>(object_)->contents = move(contents);
+}
+
+const BuiltinProcedure& Value::procedure() const {
+  return static_cast<const BuiltInObject*>(object_)->procedure;
+}
+
+const LiteralType* Value::literal_type() const {
+  switch (type_) {
+  case Undefined:
+  case Empty:
+    return LiteralType::empty();
+  case Bool:
+    return LiteralType::boolean();
+  case Int:
+  case BigInt:
+    return LiteralType::integer();
+  case String:
+    return LiteralType::string();
+  case List:
+    return static_cast<const ListObject*>(object_)->literal_type;
+  case Lambda:
+    return lambda().literal_type();
+  case Closure:
+    return function().literal_type;
+  case BuiltInProcedure:
+    return static_cast<const BuiltInObject*>(object_)->literal_type;
+  case Box:
+    return contents().literal_type();
+  }
+  return LiteralType::empty();
+}
+
+std::string Value::to_string() const {
+  switch (type_) {
+  case Undefined:
+    return "";
+  case Empty:
+    return "empty";
+  case Bool:
+    return bool_ ? "true" : "false";
+  case Int:
+    return std::to_string(int_);
+  case BigInt:
+    return bigIntegerToString(as_big_integer());
+  case String:
+    return as_string();
+  case List: {
+    std::string str("(");
+    for (const Value* l = this; l->type_ == List; l = &l->rest()) {
+      str += l->first().to_string() + " ";
+    }
+    str.back() = ')';
+    return str;
+  }
+  case Lambda:
+    return lambda().value();
+  case Closure:
+    return function().source;
+  case BuiltInProcedure:
+    return static_cast<const BuiltInObject*>(object_)->name;
+  case Box:
+    return contents().to_string();
+  }
+  return "";
+}
@@ -0,0 +1,266 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <ciso646>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Cell.h"
+#include "LiteralType.h"
+#include "bigint/BigInteger.h"
+
+class Value;
+struct Function;
+
+typedef std::vector<Value> Values;
+typedef std::function<Value(const Values&)> BuiltinProcedure;
+
+/* Payload of every value that does not fit in a machine word. A Value holds
+ * a counted reference to it, so copying a Value never copies the payload. */
+class HeapObject {
+public:
+	virtual ~HeapObject() { }
+
+private:
+	friend class Value;
+
+	int references_ = 0;
+};
+
+/* A run-time value: a one-byte tag plus either an immediate (bool, small
+ * integer) or a pointer to a HeapObject. Cells are only used for the parse
+ * tree; everything the interpreter computes is a Value. */
+class Value {
+public:
+	enum Type : uint8_t {
+		/* Marks a frame slot or global whose definition hasn't run yet. */
+		Undefined,
+		Empty,
+		Bool,
+		Int,
+		/* Types from here on live in a HeapObject. */
+		BigInt,
+		String,
+		List,
+		Lambda,
+		/* A lambda compiled for the virtual machine or the ClosureCompiler. */
+		Closure,
+		BuiltInProcedure,
+		/* Holds a variable that closures capture before it is defined. The
+		 * only mutable object, and never the value of an expression. */
+		Box
+	};
+
+	Value() : type_(Empty), int_(0) { }
+
+	Value(const Value& v) : type_(v.type_), int_(v.int_) { retain(); }
+
+	Value(Value&& v) noexcept : type_(v.type_), int_(v.int_) {
+		v.type_ = Empty;
+	}
+
+	~Value() { release(); }
+
+	Value& operator=(const Value& v);
+
+	Value& operator=(Value&& v) noexcept;
+
+	static Value undefined();
+
+	static Value boolean(bool b);
+
+	static Value integer(int64_t i);
+
+	static Value integer(BigInteger i);
+
+	static Value string(const std::string& s);
+
+	static Value cons(Value first, Value rest, const LiteralType* literal_type);
+
+	static Value list(const Values& elements, const LiteralType* literal_type);
+
+	/* lambda points into a tree that it keeps alive, and that must not
+	 * change from then on. captures are the values of the variables listed
+	 * in lambda->captures(). */
+	static Value lambda(std::shared_ptr<const Cell> lambda, Values captures);
+
+	static Value closure(std::shared_ptr<const Function> function, 
+		Values captures);
+
+	static Value builtin(BuiltinProcedure procedure, const std::string& name,
+		const LiteralType* literal_type);
+
+	static Value literal(const Cell& c);
+
+	/* A Box and the closures that capture it can refer to each other, so
+	 * every so many boxes made, the cycles among values that nothing else
+	 * refers to are looked for and freed. */
+	static Value box(Value contents);
+
+	Type type() const { return type_; }
+
+	bool is_defined() const { return type_ != Undefined; }
+
+	bool is_empty() const { return type_ == Empty; }
+
+	bool is_int() const { return type_ == Int or type_ == BigInt; }
+
+	bool as_bool() const { return bool_; }
+
+	int64_t as_int() const { return int_; }
+
+	BigInteger as_big_integer() const;
+
+	const std::string& as_string() const;
+
+	/* A list is a chain of shared, immutable cons nodes, so first and rest
+	 * are O(1) and never copy. */
+	const Value& first() const;
+
+	const Value& rest() const;
+
+	const Cell& lambda() const;
+
+	const std::shared_ptr<const Cell>& shared_lambda() const;
+
+	const Function& function() const;
+
+	/* The captures of a Lambda or Closure. */
+	const Values& captures() const;
+
+	const Value& contents() const;
+
+	void set_contents(Value contents);
+
+	const BuiltinProcedure& procedure() const;
+
+	const LiteralType* literal_type() const;
+
+	std::string to_string() const;
+
+private:
+	Value(Type type, HeapObject* object);
+
+	bool is_heap() const { return type_ >= BigInt; }
+
+	void retain() {
+		if (is_heap()) ++object_->references_;
+	}
+
+	void release() {
+		if (is_heap() and --object_->references_ == 0) destroy();
+	}
+
+	void destroy();
+
+	/* Calls f with each value the object refers to. */
+	template <class F>
+	static void for_each_reference(Type type, HeapObject* object, F f);
+
+	/* Empties the boxes that only cycles of garbage refer to, so that
+	 * those cycles are freed. */
+	static void collect_cycles();
+
+	Type type_;
+
+	union {
+		bool bool_;
+		int64_t int_;
+		HeapObject* object_;
+	};
+};
+
+static_assert(sizeof(Value) == 16, "Value must stay two machine words");
+
+struct BigIntObject : public HeapObject {
+	BigIntObject(BigInteger value) : value(std::move(value)) { }
+
+	BigInteger value;
+};
+
+struct StringObject : public HeapObject {
+	StringObject(const std::string& value) : value(value) { }
+
+	std::string value;
+};
+
+struct ListObject : public HeapObject {
+	ListObject(Value first, Value rest, const LiteralType* literal_type)
+		: first(std::move(first)), rest(std::move(rest)), 
+		  literal_type(literal_type) { }
+
+	Value first;
+
+	/* Either another List or Empty. */
+	Value rest;
+
+	const LiteralType* literal_type;
+};
+
+struct LambdaObject : public HeapObject {
+	LambdaObject(std::shared_ptr<const Cell> lambda, Values captures)
+		: lambda(std::move(lambda)), captures(std::move(captures)) { }
+
+	std::shared_ptr<const Cell> lambda;
+
+	Values captures;
+};
+
+struct ClosureObject : public HeapObject {
+	ClosureObject(std::shared_ptr<const Function> function, Values captures)
+		: function(std::move(function)), captures(std::move(captures)) { }
+
+	std::shared_ptr<const Function> function;
+
+	Values captures;
+};
+
+struct BuiltInObject : public HeapObject {
+	BuiltInObject(BuiltinProcedure procedure, const std::string& name,
+				  const LiteralType* literal_type)
+		: procedure(std::move(procedure)), name(name),
+		  literal_type(literal_type) { }
+
+	BuiltinProcedure procedure;
+
+	std::string name;
+
+	const LiteralType* literal_type;
+};
+
+/* Every live box is on a list, for the cycle collector to start from. */
+struct BoxObject : public HeapObject {
+	BoxObject(Value contents);
+
+	~BoxObject();
+
+	Value contents;
+
+	BoxObject* previous;
+
+	BoxObject* next;
+};
@@ -0,0 +1,196 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#include "VirtualMachine.h"
+#include "Compiler.h"
+#include "Context.h"
+#include "InterpreterExceptions.h"
+#include "SymbolTable.h"
+
+#include <ciso646>
+#include <iterator>
+
+using namespace std;
+
+Value VirtualMachine::run(const Cell& c, shared_ptr<Context> ctx) {
+	VirtualMachine vm(move(ctx));
+	return vm.execute(Compiler::compile(c));
+}
+
+VirtualMachine::VirtualMachine(shared_ptr<Context> global)
+	: global_(move(global)) {
+}
+
+VirtualMachine::~VirtualMachine() {
+	while (not frames_.empty()) 
+		frames_.pop_back();
+}
+
+Value VirtualMachine::execute(shared_ptr<const Function> function) {
+	frames_.push_back(Frame{function.get(), Value(), function->code.data(),
+		Context(global_.get(), 0), 0});
+
+	while (true) {
+		auto& frame = frames_.back();
+		const auto& f = *frame.function;
+		const auto& i = *frame.pc++;
+
+		switch (i.op) {
+		case Instruction::Constant:
+			stack_.push_back(f.constants[i.a]);
+			break;
+
+		case Instruction::LoadGlobal: {
+			const auto& v = global_->get_global(i.a);
+			if (not v.is_defined())
+				throw ContextException(SymbolTable::name(i.a));
+			stack_.push_back(v);
+			break;
+		}
+
+		case Instruction::LoadLocal:
+		case Instruction::LoadCapture: {
+			const auto* v = i.op == Instruction::LoadLocal 
+				? &frame.context.get_slot(i.a) : &frame.context.get_capture(i.a);
+			if (i.b)
+				v = &v->contents();
+			if (not v->is_defined())
+				throw ContextException(SymbolTable::name(i.c));
+			stack_.push_back(*v);
+			break;
+		}
+
+		case Instruction::DefineGlobal:
+			global_->set_global(i.a, stack_.back());
+			break;
+
+		case Instruction::DefineLocal:
+			if (i.b) {
+				frame.context.get_slot(i.a).set_contents(stack_.back());
+			} else {
+				frame.context.set(i.a, stack_.back());
+			}
+			break;
+
+		case Instruction::MakeBox: {
+			auto& slot = frame.context.get_slot(i.a);
+			slot = Value::box(move(slot));
+			break;
+		}
+
+		case Instruction::Pop:
+			stack_.pop_back();
+			break;
+
+		case Instruction::Jump:
+			frame.pc = f.code.data() + i.a;
+			break;
+
+		case Instruction::JumpIfFalse: {
+			if (not stack_.back().as_bool())
+				frame.pc = f.code.data() + i.a;
+			stack_.pop_back();
+			break;
+		}
+
+		case Instruction::MakeClosure: {
+			const auto& g = f.functions[i.a];
+			stack_.push_back(Value::closure(g, 
+				frame.context.capture(g->captures)));
+			break;
+		}
+
+		case Instruction::Call:
+		case Instruction::TailCall: {
+			const auto& callee = stack_[stack_.size() - i.a - 1];
+			if (callee.type() == Value::Closure) {
+				call_closure(i.a, i.op == Instruction::TailCall);
+			} else if (callee.type() == Value::BuiltInProcedure) {
+				call_builtin(i.a);
+			} else {
+				throw InterpreterException("Undefined procedure: "
+					+ callee.to_string() + ".");
+			}
+			break;
+		}
+
+		case Instruction::Return: {
+			auto result = move(stack_.back());
+			stack_.resize(frame.base);
+			frames_.pop_back();
+			if (frames_.empty())
+				return result;
+			stack_.push_back(move(result));
+			break;
+		}
+
+		/* Only the top-level form has local blocks with frames, and its
+		 * own frame is empty, so they are simply swapped. */
+		case Instruction::EnterFrame:
+			frame.context.reset(i.a, nullptr);
+			break;
+
+		case Instruction::LeaveFrame:
+			frame.context.reset(0, nullptr);
+			break;
+		}
+	}
+}
+
+void VirtualMachine::call_closure(int argc, bool tail) {
+	auto callee_index = stack_.size() - argc - 1;
+	auto closure = move(stack_[callee_index]);
+	const auto& function = closure.function();
+
+	/* A tail call takes over the caller's frame. */
+	const auto* code = function.code.data();
+	if (tail) {
+		auto& frame = frames_.back();
+		frame.context.reset(function.frame_size, &closure.captures());
+		for (int i = 0; i < argc; ++i) {
+			frame.context.set(i, move(stack_[callee_index + 1 + i]));
+		}
+		stack_.resize(frame.base);
+		frame.function = &function;
+		frame.closure = move(closure);
+		frame.pc = code;
+	} else {
+		Context ctx(global_.get(), function.frame_size, &closure.captures());
+		for (int i = 0; i < argc; ++i) {
+			ctx.set(i, move(stack_[callee_index + 1 + i]));
+		}
+		stack_.resize(callee_index);
+		frames_.push_back(Frame{&function, move(closure), code, move(ctx),
+			stack_.size()});
+	}
+}
+
+void VirtualMachine::call_builtin(int argc) {
+	auto callee_index = stack_.size() - argc - 1;
+	arguments_.assign(make_move_iterator(stack_.begin() + callee_index + 1),
+		make_move_iterator(stack_.end()));
+	auto result = stack_[callee_index].procedure()(arguments_);
+	arguments_.clear();
+	stack_.resize(callee_index);
+	stack_.push_back(move(result));
+}
@@ -0,0 +1,82 @@
+/*
+* MIT License
+* 
+* Copyright (c) 2013 Alex Gliesch
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Context.h"
+#include "Function.h"
+
+class Cell;
+
+/* Stack-based virtual machine running code from the Compiler. It is an
+ * alternative to the Interpreter: both share Contexts, Values and
+ * built-ins, but calls here never recurse on the native stack, and tail
+ * calls run in constant space. */
+class VirtualMachine {
+public:
+	/* Compiles a resolved top-level form and runs it. */
+	static Value run(const Cell& c, std::shared_ptr<Context> ctx);
+
+private:
+	/* An activation of a Function. */
+	struct Frame {
+		const Function* function;
+
+		/* Keeps function and its captures alive; empty for the top-level
+		 * form. */
+		Value closure;
+
+		const Instruction* pc;
+
+		/* Empty for the top-level form, but for its local blocks. */
+		Context context;
+
+		/* Height of the stack when the activation began. */
+		size_t base;
+	};
+
+	VirtualMachine(std::shared_ptr<Context> global);
+
+	/* Frees the frames in the reverse order of their opening, even when
+	 * an error left some of them open. */
+	~VirtualMachine();
+
+	Value execute(std::shared_ptr<const Function> function);
+
+	/* Opens an activation of the closure below the topmost argc values,
+	 * consuming them. If tail is set it replaces the current one. */
+	void call_closure(int argc, bool tail);
+
+	void call_builtin(int argc);
+
+	std::shared_ptr<Context> global_;
+
+	Values stack_;
+
+	std::vector<Frame> frames_;
+
+	/* Argument buffer reused across built-in calls. */
+	Values arguments_;
+};
@@ -1,13 +1,23 @@
 #include "BigInteger.h"
 
-void BigInteger::operator =(const BigInteger &x) {
+BigInteger &BigInteger::operator =(const BigInteger &x) {
 	// Calls like a = a have no effect
 	if (this == &x)
-		return;
+		return *this;
 	// Copy sign
 	sign = x.sign;
 	// Copy the rest
 	mag = x.mag;
+	return *this;
+}
+
+BigInteger &BigInteger::operator =(BigInteger &&x) noexcept {
+	if (this == &x)
+		return *this;
+	sign = x.sign;
+	mag = std::move(x.mag);
+	x.sign = zero;
+	return *this;
 }
 
 BigInteger::BigInteger(const Blk *b, Index blen, Sign s) : mag(b, blen) {
@@ -29,11 +39,11 @@ BigInteger::BigInteger(const Blk *b, Index blen, Sign s) : mag(b, blen) {
 	}
 }
 
-BigInteger::BigInteger(const BigUnsigned &x, Sign s) : mag(x) {
+BigInteger::BigInteger(BigUnsigned x, Sign s) : mag(std::move(x)) {
 	switch (s) {
 	case zero:
 		if (!mag.isZero())
-			throw "BigInteger::BigInteger(const BigUnsigned &, Sign): Cannot use a sign of zero with a nonzero magnitude";
+			throw "BigInteger::BigInteger(BigUnsigned, Sign): Cannot use a sign of zero with a nonzero magnitude";
 		sign = zero;
 		break;
 	case positive:
@@ -44,7 +54,7 @@ BigInteger::BigInteger(const BigUnsigned &x, Sign s) : mag(x) {
 	default:
 		/* g++ seems to be optimizing out this case on the assumption
 		 * that the sign is a valid member of the enumeration.  Oh well. */
-		throw "BigInteger::BigInteger(const BigUnsigned &, Sign): Invalid sign";
+		throw "BigInteger::BigInteger(BigUnsigned, Sign): Invalid sign";
 	}
 }
 
@@ -162,7 +172,7 @@ BigInteger::CmpRes BigInteger::compareTo(const BigInteger &x) const {
 	if (cond) { \
 		BigInteger tmpThis; \
 		tmpThis.op; \
-		*this = tmpThis; \
+		*this = std::move(tmpThis); \
 		return; \
 	}
 
@@ -34,8 +34,14 @@ public:
 	// Copy constructor
 	BigInteger(const BigInteger &x) : sign(x.sign), mag(x.mag) {};
 
-	// Assignment operator
-	void operator=(const BigInteger &x);
+	// Move constructor.  Leaves x zero.
+	BigInteger(BigInteger &&x) noexcept : sign(x.sign), mag(std::move(x.mag)) {
+		x.sign = zero;
+	}
+
+	// Assignment operators
+	BigInteger &operator=(const BigInteger &x);
+	BigInteger &operator=(BigInteger &&x) noexcept;
 
 	// Constructor that copies from a given array of blocks with a sign.
 	BigInteger(const Blk *b, Index blen, Sign s);
@@ -45,11 +51,12 @@ public:
 		sign = mag.isZero() ? zero : positive;
 	}
 
-	// Constructor from a BigUnsigned and a sign
-	BigInteger(const BigUnsigned &x, Sign s);
+	/* Constructor from a BigUnsigned and a sign.  The magnitude is taken by
+	 * value so that a temporary can be moved in. */
+	BigInteger(BigUnsigned x, Sign s);
 
 	// Nonnegative constructor from a BigUnsigned
-	BigInteger(const BigUnsigned &x) : mag(x) {
+	BigInteger(BigUnsigned x) : mag(std::move(x)) {
 		sign = mag.isZero() ? zero : positive;
 	}
 
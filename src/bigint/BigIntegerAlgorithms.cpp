@@ -1,43 +1,168 @@
 #include "BigIntegerAlgorithms.h"
+#include "BlockArithmetic.h"
+#include <cmath>
+#include <memory>
+
+typedef BigUnsigned::Index Index;
+
+// Returns the number of trailing zero bits of `x', which must be nonzero.
+static inline unsigned int trailingZeros(Blk x) {
+#ifdef __GNUC__
+	return __builtin_ctzl(x);
+#else
+	unsigned int n = 0;
+	while ((x & 1) == 0) {
+		x >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+// Stein's binary GCD, for numbers down to a single block.
+static Blk binaryGcd(Blk a, Blk b) {
+	if (a == 0)
+		return b;
+	if (b == 0)
+		return a;
+	unsigned int shift = trailingZeros(a | b);
+	a >>= trailingZeros(a);
+	do {
+		b >>= trailingZeros(b);
+		if (a > b)
+			std::swap(a, b);
+		b -= a;
+	} while (b != 0);
+	return a << shift;
+}
+
+/*
+ * Lehmer's algorithm runs Euclid's on the leading bits of a and b, in
+ * single precision, for as long as the quotients are sure to match those
+ * of the full numbers, then applies all those steps at once:
+ *     (a, b) <- (m[0] a + m[1] b, m[2] a + m[3] b).
+ * The leading bits are cut to two short of a block so that the cosequence
+ * fits in a signed one.
+ *
+ * Requires a >= b > 0.  Returns false when not even the first quotient is
+ * certain (say, when b is much shorter than a), and a division is needed.
+ */
+static bool lehmerCosequence(const BigUnsigned &a, const BigUnsigned &b, long m[4]) {
+	const Index leadingBits = blockBits - 2;
+	Index shift = (a.bitLength() > leadingBits) ? a.bitLength() - leadingBits : 0;
+	Index block = shift / blockBits, offset = shift % blockBits;
+	long x = long(a.getBlock(block) >> offset), y = long(b.getBlock(block) >> offset);
+	if (offset != 0) {
+		x |= long(a.getBlock(block + 1) << (blockBits - offset));
+		y |= long(b.getBlock(block + 1) << (blockBits - offset));
+	}
+	x &= (long(1) << leadingBits) - 1;
+	y &= (long(1) << leadingBits) - 1;
+	long A = 1, B = 0, C = 0, D = 1;
+	// x + A and x + B bracket the current leading bits of a, likewise for b.
+	while (y + C > 0 && y + D > 0) {
+		long q = (x + A) / (y + C);
+		if (q != (x + B) / (y + D))
+			break;
+		long t = A - q * C;
+		A = C;
+		C = t;
+		t = B - q * D;
+		B = D;
+		D = t;
+		t = x - q * y;
+		x = y;
+		y = t;
+	}
+	m[0] = A;
+	m[1] = B;
+	m[2] = C;
+	m[3] = D;
+	return B != 0;
+}
+
+/* Returns u a + v b, where one of u and v is nonnegative and the other
+ * nonpositive, as in a row of the cosequence, and the result is known to
+ * be nonnegative. */
+static BigUnsigned combine(long u, const BigUnsigned &a, long v, const BigUnsigned &b) {
+	if (v > 0)
+		return combine(v, b, u, a);
+	Blk x = Blk(u), y = Blk(-v);
+	Index n = (a.getLength() > b.getLength()) ? a.getLength() : b.getLength(), i;
+	std::vector<Blk> r(n + 1);
+	Blk carryA = 0, carryB = 0, borrow = 0;
+	for (i = 0; i < n; i++) {
+		// r[i] = low(x a) - low(y b) - borrow
+		Blk p = multiplyAdd(x, a.getBlock(i), carryA, 0, carryA);
+		Blk q = multiplyAdd(y, b.getBlock(i), carryB, 0, carryB);
+		Blk d = p - q;
+		Blk nextBorrow = (p < q);
+		nextBorrow += (d < borrow);
+		r[i] = d - borrow;
+		borrow = nextBorrow;
+	}
+	r[n] = carryA - carryB - borrow;
+	return BigUnsigned(&r[0], n + 1);
+}
 
 BigUnsigned gcd(BigUnsigned a, BigUnsigned b) {
-	BigUnsigned trash;
-	// Neat in-place alternating technique.
-	for (;;) {
-		if (b.isZero())
-			return a;
-		a.divideWithRemainder(b, trash);
-		if (a.isZero())
-			return b;
-		b.divideWithRemainder(a, trash);
+	if (a < b)
+		std::swap(a, b);
+	long m[4];
+	while (b.getLength() > 1) {
+		if (lehmerCosequence(a, b, m)) {
+			BigUnsigned a2 = combine(m[0], a, m[1], b);
+			b = combine(m[2], a, m[3], b);
+			a = std::move(a2);
+		} else {
+			a %= b;
+			std::swap(a, b);
+		}
 	}
+	if (b.isZero())
+		return a;
+	// One block left: finish in single precision.
+	a %= b;
+	return BigUnsigned(binaryGcd(a.getBlock(0), b.getBlock(0)));
 }
 
+/*
+ * Lehmer's algorithm again, keeping only the cofactors of |m|: each of a
+ * and b is (its cofactor) |m| + (something) |n|.  The cofactor of |n| at
+ * the end follows from that by one exact division.
+ */
 void extendedEuclidean(BigInteger m, BigInteger n,
 		BigInteger &g, BigInteger &r, BigInteger &s) {
 	if (&g == &r || &g == &s || &r == &s)
 		throw "BigInteger extendedEuclidean: Outputs are aliased";
-	BigInteger r1(1), s1(0), r2(0), s2(1), q;
-	/* Invariants:
-	 * r1*m(orig) + s1*n(orig) == m(current)
-	 * r2*m(orig) + s2*n(orig) == n(current) */
-	for (;;) {
-		if (n.isZero()) {
-			r = r1; s = s1; g = m;
-			return;
-		}
-		// Subtract q times the second invariant from the first invariant.
-		m.divideWithRemainder(n, q);
-		r1 -= q*r2; s1 -= q*s2;
-
-		if (m.isZero()) {
-			r = r2; s = s2; g = n;
-			return;
+	BigUnsigned a = m.getMagnitude(), b = n.getMagnitude(), q;
+	BigInteger ra(1), rb(0);
+	if (a < b) {
+		std::swap(a, b);
+		std::swap(ra, rb);
+	}
+	long c[4];
+	while (!b.isZero()) {
+		if (lehmerCosequence(a, b, c)) {
+			BigUnsigned a2 = combine(c[0], a, c[1], b);
+			b = combine(c[2], a, c[3], b);
+			a = std::move(a2);
+			BigInteger ra2 = BigInteger(c[0]) * ra + BigInteger(c[1]) * rb;
+			rb = BigInteger(c[2]) * ra + BigInteger(c[3]) * rb;
+			ra = std::move(ra2);
+		} else {
+			a.divideWithRemainder(b, q);
+			std::swap(a, b);
+			ra -= BigInteger(q) * rb;
+			std::swap(ra, rb);
 		}
-		// Subtract q times the first invariant from the second invariant.
-		n.divideWithRemainder(m, q);
-		r2 -= q*r1; s2 -= q*s1;
 	}
+	g = a;
+	// ra |m| + (g - ra |m|) / |n| |n| == g, and flipping signs for m and n:
+	BigInteger sa = n.isZero() ? BigInteger(0)
+		: (BigInteger(a) - ra * BigInteger(m.getMagnitude())) / BigInteger(n.getMagnitude());
+	r = (m.getSign() == BigInteger::negative) ? -ra : ra;
+	s = (n.getSign() == BigInteger::negative) ? -sa : sa;
 }
 
 BigUnsigned modinv(const BigInteger &x, const BigUnsigned &n) {
@@ -50,21 +175,181 @@ BigUnsigned modinv(const BigInteger &x, const BigUnsigned &n) {
 		throw "BigInteger modinv: x and n have a common factor";
 }
 
+BigUnsigned isqrt(const BigUnsigned &n) {
+	if (n.isZero())
+		return n;
+	/* Guess from the top (at most 63) bits of n, shifted off in an even
+	 * number so that the root of the rest scales back exactly.  The +2
+	 * covers the rounding of the double, so the guess is above the root. */
+	Index bits = n.bitLength();
+	Index shift = (bits > 63) ? (bits - 63 + 1) & ~Index(1) : 0;
+	Blk top = (n >> int(shift)).getBlock(0);
+	BigUnsigned x = BigUnsigned((unsigned long)std::sqrt(double(top)) + 2) << int(shift / 2);
+	/* From above, Newton's iteration for x^2 - n decreases strictly until it
+	 * reaches floor(sqrt(n)), which is where it first stops decreasing. */
+	for (;;) {
+		BigUnsigned y = (x + n / x) >> 1;
+		if (y >= x)
+			return x;
+		x = y;
+	}
+}
+
+/*
+ * Returns base^exponent, for exponent > 0, by left-to-right sliding
+ * windows: each run of at most k bits that starts and ends with a one
+ * costs one multiplication by a precomputed odd power of `base', and every
+ * bit costs a squaring.  `multiply(r, x, y)' sets r = x y, where `r' may be
+ * `x' or `y'.
+ */
+template <class Element, class Multiply>
+static Element slidingWindowPower(const Element &base, const BigUnsigned &exponent,
+		Multiply multiply) {
+	typedef BigUnsigned::Index Index;
+	Index bits = exponent.bitLength(), i, j;
+	// Window widths that minimize the multiplications for each size
+	unsigned int k = bits <= 8 ? 1 : bits <= 24 ? 2 : bits <= 80 ? 3
+		: bits <= 240 ? 4 : bits <= 672 ? 5 : 6;
+	// odd[i] = base^(2i + 1)
+	std::vector<Element> odd(size_t(1) << (k - 1), base);
+	if (k > 1) {
+		Element square(base);
+		multiply(square, base, base);
+		for (i = 1; i < odd.size(); i++)
+			multiply(odd[i], odd[i - 1], square);
+	}
+	Element result;
+	bool started = false;
+	// The bits below `i' are yet to be processed.
+	for (i = bits; i > 0; ) {
+		if (!exponent.getBit(i - 1)) {
+			multiply(result, result, result);
+			i--;
+			continue;
+		}
+		// The window is bits [low, i), with a one at both ends.
+		Index low = (i > k) ? i - k : 0;
+		while (!exponent.getBit(low))
+			low++;
+		size_t window = 0;
+		for (j = i; j > low; j--)
+			window = (window << 1) | exponent.getBit(j - 1);
+		if (started) {
+			for (j = low; j < i; j++)
+				multiply(result, result, result);
+			multiply(result, result, odd[window >> 1]);
+		} else {
+			result = odd[window >> 1];
+			started = true;
+		}
+		i = low;
+	}
+	return result;
+}
+
+/* The Montgomery context of the last odd modulus that modexp saw on this
+ * thread, so that a batch of exponentiations modulo the same number sets up
+ * only once. */
+static const MontgomeryContext &montgomeryContextFor(const BigUnsigned &modulus) {
+	static thread_local std::unique_ptr<MontgomeryContext> cached;
+	if (!cached || cached->getModulus() != modulus)
+		cached.reset(new MontgomeryContext(modulus));
+	return *cached;
+}
+
 BigUnsigned modexp(const BigInteger &base, const BigUnsigned &exponent,
 		const BigUnsigned &modulus) {
-	BigUnsigned ans = 1, base2 = (base % modulus).getMagnitude();
-	BigUnsigned::Index i = exponent.bitLength();
-	// For each bit of the exponent, most to least significant...
-	while (i > 0) {
-		i--;
-		// Square.
-		ans *= ans;
-		ans %= modulus;
-		// And multiply if the bit is a 1.
-		if (exponent.getBit(i)) {
-			ans *= base2;
-			ans %= modulus;
-		}
+	BigUnsigned base2 = (base % modulus).getMagnitude();
+	if (modulus.getBit(0))
+		return montgomeryContextFor(modulus).modexp(base2, exponent);
+	// Reduce the 1 too, so that anything modulo 1 is 0.
+	if (exponent.isZero())
+		return BigUnsigned(1) % modulus;
+	return slidingWindowPower(base2, exponent,
+		[&modulus](BigUnsigned &r, const BigUnsigned &x, const BigUnsigned &y) {
+			r = x * y;
+			r %= modulus;
+		});
+}
+
+MontgomeryContext::MontgomeryContext(const BigUnsigned &modulus) : modulus(modulus) {
+	if (!modulus.getBit(0))
+		throw "MontgomeryContext: The modulus must be odd";
+	n = modulus.getLength();
+	m.resize(n);
+	for (Index i = 0; i < n; i++)
+		m[i] = modulus.getBlock(i);
+	// Newton's iteration doubles the correct low bits of 1/m[0] each time.
+	Blk inverse = m[0];
+	for (unsigned int bits = 3; bits < blockBits; bits *= 2)
+		inverse *= 2 - m[0] * inverse;
+	negInverse = 0 - inverse;
+	BigUnsigned r2Big = BigUnsigned(1);
+	r2Big.bitShiftLeft(r2Big, int(2 * n * blockBits));
+	r2Big %= modulus;
+	r2.assign(n, 0);
+	for (Index i = 0; i < r2Big.getLength(); i++)
+		r2[i] = r2Big.getBlock(i);
+}
+
+/* Coarsely Integrated Operand Scanning: each round adds a[] b[i] to the
+ * accumulator, then the multiple of m that clears its low block, and drops
+ * that block.  The accumulator stays below 2m. */
+void MontgomeryContext::multiply(Blk *r, const Blk *a, const Blk *b, Blk *scratch) const {
+	Blk *t = scratch, carry, sum;
+	Index i, j;
+	for (j = 0; j < n + 2; j++)
+		t[j] = 0;
+	for (i = 0; i < n; i++) {
+		carry = 0;
+		for (j = 0; j < n; j++)
+			t[j] = multiplyAdd(a[j], b[i], t[j], carry, carry);
+		sum = t[n] + carry;
+		t[n + 1] = (sum < carry);
+		t[n] = sum;
+
+		Blk u = t[0] * negInverse;
+		multiplyAdd(u, m[0], t[0], 0, carry);
+		for (j = 1; j < n; j++)
+			t[j - 1] = multiplyAdd(u, m[j], t[j], carry, carry);
+		sum = t[n] + carry;
+		t[n - 1] = sum;
+		t[n] = t[n + 1] + (sum < carry);
+	}
+	// Subtract m once if the accumulator reached it.
+	bool reduce = (t[n] != 0);
+	if (!reduce) {
+		for (j = n; j > 0 && t[j - 1] == m[j - 1]; j--)
+			;
+		reduce = (j == 0 || t[j - 1] > m[j - 1]);
+	}
+	Blk borrow = 0;
+	for (j = 0; j < n; j++) {
+		Blk x = t[j], y = reduce ? m[j] : 0;
+		Blk d = x - y - borrow;
+		borrow = (x < y) || (x == y && borrow);
+		r[j] = d;
+	}
+}
+
+BigUnsigned MontgomeryContext::modexp(const BigUnsigned &base, const BigUnsigned &exponent) const {
+	std::vector<Blk> scratch(n + 2), x(n, 0), one(n, 0);
+	one[0] = 1;
+	if (exponent.isZero()) {
+		// R mod m is 1 in Montgomery form.
+		multiply(&x[0], &one[0], &r2[0], &scratch[0]);
+	} else {
+		BigUnsigned reduced = base % modulus;
+		for (Index i = 0; i < reduced.getLength(); i++)
+			x[i] = reduced.getBlock(i);
+		multiply(&x[0], &x[0], &r2[0], &scratch[0]);
+		x = slidingWindowPower(x, exponent,
+			[this, &scratch](std::vector<Blk> &r, const std::vector<Blk> &a,
+					const std::vector<Blk> &b) {
+				multiply(&r[0], &a[0], &b[0], &scratch[0]);
+			});
 	}
-	return ans;
+	// Multiplying by a plain 1 divides out R.
+	multiply(&x[0], &x[0], &one[0], &scratch[0]);
+	return BigUnsigned(&x[0], n);
 }
@@ -2,15 +2,17 @@
 #define BIGINTEGERALGORITHMS_H
 
 #include "BigInteger.h"
+#include <vector>
 
 /* Some mathematical algorithms for big integers.
  * This code is new and, as such, experimental. */
 
-// Returns the greatest common divisor of a and b.
+// Returns the greatest common divisor of a and b, by Lehmer's algorithm.
 BigUnsigned gcd(BigUnsigned a, BigUnsigned b);
 
-/* Extended Euclidean algorithm.
- * Given m and n, finds gcd g and numbers r, s such that r*m + s*n == g. */
+/* Extended Euclidean algorithm, also Lehmer's.
+ * Given m and n, finds gcd g >= 0 and numbers r, s such that
+ * r*m + s*n == g. */
 void extendedEuclidean(BigInteger m, BigInteger n,
 		BigInteger &g, BigInteger &r, BigInteger &s);
 
@@ -18,8 +20,43 @@ void extendedEuclidean(BigInteger m, BigInteger n,
  * they have a common factor. */
 BigUnsigned modinv(const BigInteger &x, const BigUnsigned &n);
 
-// Returns (base ^ exponent) % modulus.
+// Returns floor(sqrt(n)), by Newton's method.
+BigUnsigned isqrt(const BigUnsigned &n);
+
+/* Returns (base ^ exponent) % modulus, by sliding windows over the bits of
+ * the exponent.  An odd modulus goes through a MontgomeryContext, the last
+ * of which is kept (per thread) for the next call with the same modulus. */
 BigUnsigned modexp(const BigInteger &base, const BigUnsigned &exponent,
 		const BigUnsigned &modulus);
 
+/* Arithmetic modulo a fixed odd modulus m in Montgomery form, where x
+ * stands for x R mod m with R the power of the block base just above m.
+ * Products are then reduced with multiplications instead of a division.
+ * Setting up takes a division, so keep a context for repeated use. */
+class MontgomeryContext {
+public:
+	typedef BigUnsigned::Blk Blk;
+	typedef BigUnsigned::Index Index;
+
+	// Throws if the modulus is even (or 0).
+	explicit MontgomeryContext(const BigUnsigned &modulus);
+
+	const BigUnsigned &getModulus() const { return modulus; }
+
+	// Returns (base ^ exponent) % the modulus.
+	BigUnsigned modexp(const BigUnsigned &base, const BigUnsigned &exponent) const;
+
+private:
+	BigUnsigned modulus;
+	// The modulus and R^2 mod m, in `n' blocks each
+	std::vector<Blk> m, r2;
+	Index n;
+	// -1/m modulo the block base
+	Blk negInverse;
+
+	/* Sets `r' to a b / R mod m, for a, b < m.  `r' may be `a' or `b', and
+	 * `scratch' has room for n + 2 blocks. */
+	void multiply(Blk *r, const Blk *a, const Blk *b, Blk *scratch) const;
+};
+
 #endif
@@ -1,4 +1,9 @@
 #include "BigUnsigned.h"
+#include "BlockArithmetic.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
 
 // Memory management definitions have moved to the bottom of NumberlikeArray.hh.
 
@@ -115,12 +120,99 @@ BigUnsigned::CmpRes BigUnsigned::compareTo(const BigUnsigned &x) const {
 	if (cond) { \
 		BigUnsigned tmpThis; \
 		tmpThis.op; \
-		*this = tmpThis; \
+		*this = std::move(tmpThis); \
 		return; \
 	}
 
 
 
+/*
+ * BLOCK KERNELS FOR ADDITION, SUBTRACTION AND SHIFTS
+ * These run along raw block arrays, least significant block first, with
+ * the carry held in a block so that `addCarry' and `subtractBorrow' can
+ * chain the processor's add-with-carry instructions.  The main loops are
+ * unrolled four times.
+ */
+
+typedef BigUnsigned::Index Index;
+
+// Sets r[0..n) to a[0..n) + b[0..m), where m <= n, and returns the carry.
+// `r' may be `a'.
+static Blk addBlocks(Blk *r, const Blk *a, Index n, const Blk *b, Index m) {
+	Carry carry = 0;
+	Index i;
+	for (i = 0; i + 4 <= m; i += 4) {
+		r[i] = addCarry(a[i], b[i], carry);
+		r[i + 1] = addCarry(a[i + 1], b[i + 1], carry);
+		r[i + 2] = addCarry(a[i + 2], b[i + 2], carry);
+		r[i + 3] = addCarry(a[i + 3], b[i + 3], carry);
+	}
+	for (; i < m; i++)
+		r[i] = addCarry(a[i], b[i], carry);
+	for (; i < n && carry != 0; i++)
+		r[i] = addCarry(a[i], 0, carry);
+	if (r != a)
+		for (; i < n; i++)
+			r[i] = a[i];
+	return carry;
+}
+
+// Sets r[0..n) to a[0..n) - b[0..m), where m <= n, and returns the borrow.
+// `r' may be `a'.
+static Blk subtractBlocks(Blk *r, const Blk *a, Index n, const Blk *b, Index m) {
+	Carry borrow = 0;
+	Index i;
+	for (i = 0; i + 4 <= m; i += 4) {
+		r[i] = subtractBorrow(a[i], b[i], borrow);
+		r[i + 1] = subtractBorrow(a[i + 1], b[i + 1], borrow);
+		r[i + 2] = subtractBorrow(a[i + 2], b[i + 2], borrow);
+		r[i + 3] = subtractBorrow(a[i + 3], b[i + 3], borrow);
+	}
+	for (; i < m; i++)
+		r[i] = subtractBorrow(a[i], b[i], borrow);
+	for (; i < n && borrow != 0; i++)
+		r[i] = subtractBorrow(a[i], 0, borrow);
+	if (r != a)
+		for (; i < n; i++)
+			r[i] = a[i];
+	return borrow;
+}
+
+/* Sets r[0..n) to the low n blocks of a[0..n) << bits, for 0 < bits <
+ * blockBits, and returns the bits shifted out the top.  Works from the top
+ * down, so `r' may overlap `a' from above. */
+static Blk shiftLeftBlocks(Blk *r, const Blk *a, Index n, unsigned int bits) {
+	const unsigned int back = blockBits - bits;
+	Blk out = a[n - 1] >> back;
+	Index i = n - 1;
+	for (; i >= 4; i -= 4) {
+		r[i] = (a[i] << bits) | (a[i - 1] >> back);
+		r[i - 1] = (a[i - 1] << bits) | (a[i - 2] >> back);
+		r[i - 2] = (a[i - 2] << bits) | (a[i - 3] >> back);
+		r[i - 3] = (a[i - 3] << bits) | (a[i - 4] >> back);
+	}
+	for (; i > 0; i--)
+		r[i] = (a[i] << bits) | (a[i - 1] >> back);
+	r[0] = a[0] << bits;
+	return out;
+}
+
+/* Sets r[0..n) to a[0..n) >> bits, for 0 < bits < blockBits.  Works from
+ * the bottom up, so `r' may overlap `a' from below. */
+static void shiftRightBlocks(Blk *r, const Blk *a, Index n, unsigned int bits) {
+	const unsigned int back = blockBits - bits;
+	Index i = 0;
+	for (; i + 4 < n; i += 4) {
+		r[i] = (a[i] >> bits) | (a[i + 1] << back);
+		r[i + 1] = (a[i + 1] >> bits) | (a[i + 2] << back);
+		r[i + 2] = (a[i + 2] >> bits) | (a[i + 3] << back);
+		r[i + 3] = (a[i + 3] >> bits) | (a[i + 4] << back);
+	}
+	for (; i + 1 < n; i++)
+		r[i] = (a[i] >> bits) | (a[i + 1] << back);
+	r[n - 1] = a[n - 1] >> bits;
+}
+
 void BigUnsigned::add(const BigUnsigned &a, const BigUnsigned &b) {
 	DTRT_ALIASED(this == &a || this == &b, add(a, b));
 	// If one argument is zero, copy the other.
@@ -131,11 +223,6 @@ void BigUnsigned::add(const BigUnsigned &a, const BigUnsigned &b) {
 		operator =(a);
 		return;
 	}
-	// Some variables...
-	// Carries in and out of an addition stage
-	bool carryIn, carryOut;
-	Blk temp;
-	Index i;
 	// a2 points to the longer input, b2 points to the shorter
 	const BigUnsigned *a2, *b2;
 	if (a.len >= b.len) {
@@ -148,36 +235,9 @@ void BigUnsigned::add(const BigUnsigned &a, const BigUnsigned &b) {
 	// Set prelimiary length and make room in this BigUnsigned
 	len = a2->len + 1;
 	allocate(len);
-	// For each block index that is present in both inputs...
-	for (i = 0, carryIn = false; i < b2->len; i++) {
-		// Add input blocks
-		temp = a2->blk[i] + b2->blk[i];
-		// If a rollover occurred, the result is less than either input.
-		// This test is used many times in the BigUnsigned code.
-		carryOut = (temp < a2->blk[i]);
-		// If a carry was input, handle it
-		if (carryIn) {
-			temp++;
-			carryOut |= (temp == 0);
-		}
-		blk[i] = temp; // Save the addition result
-		carryIn = carryOut; // Pass the carry along
-	}
-	// If there is a carry left over, increase blocks until
-	// one does not roll over.
-	for (; i < a2->len && carryIn; i++) {
-		temp = a2->blk[i] + 1;
-		carryIn = (temp == 0);
-		blk[i] = temp;
-	}
-	// If the carry was resolved but the larger number
-	// still has blocks, copy them over.
-	for (; i < a2->len; i++)
-		blk[i] = a2->blk[i];
-	// Set the extra block if there's still a carry, decrease length otherwise
-	if (carryIn)
-		blk[i] = 1;
-	else
+	// Set the extra block if there's a carry, decrease length otherwise
+	blk[a2->len] = addBlocks(blk, a2->blk, a2->len, b2->blk, b2->len);
+	if (blk[a2->len] == 0)
 		len--;
 }
 
@@ -191,43 +251,16 @@ void BigUnsigned::subtract(const BigUnsigned &a, const BigUnsigned &b) {
 		// If a is shorter than b, the result is negative.
 		throw "BigUnsigned::subtract: "
 			"Negative result in unsigned calculation";
-	// Some variables...
-	bool borrowIn, borrowOut;
-	Blk temp;
-	Index i;
 	// Set preliminary length and make room
 	len = a.len;
 	allocate(len);
-	// For each block index that is present in both inputs...
-	for (i = 0, borrowIn = false; i < b.len; i++) {
-		temp = a.blk[i] - b.blk[i];
-		// If a reverse rollover occurred,
-		// the result is greater than the block from a.
-		borrowOut = (temp > a.blk[i]);
-		// Handle an incoming borrow
-		if (borrowIn) {
-			borrowOut |= (temp == 0);
-			temp--;
-		}
-		blk[i] = temp; // Save the subtraction result
-		borrowIn = borrowOut; // Pass the borrow along
-	}
-	// If there is a borrow left over, decrease blocks until
-	// one does not reverse rollover.
-	for (; i < a.len && borrowIn; i++) {
-		borrowIn = (a.blk[i] == 0);
-		blk[i] = a.blk[i] - 1;
-	}
-	/* If there's still a borrow, the result is negative.
+	/* If there's a borrow left over, the result is negative.
 	 * Throw an exception, but zero out this object so as to leave it in a
 	 * predictable state. */
-	if (borrowIn) {
+	if (subtractBlocks(blk, a.blk, a.len, b.blk, b.len) != 0) {
 		len = 0;
 		throw "BigUnsigned::subtract: Negative result in unsigned calculation";
-	} else
-		// Copy over the rest of the blocks
-		for (; i < a.len; i++)
-			blk[i] = a.blk[i];
+	}
 	// Zap leading zeros
 	zapLeadingZeros();
 }
@@ -253,48 +286,548 @@ void BigUnsigned::subtract(const BigUnsigned &a, const BigUnsigned &b) {
  * would welcome contributions from others for this.
  *
  * I eventually decided to use bit-shifting algorithms.  To multiply `a'
- * and `b', we zero out the result.  Then, for each `1' bit in `a', we
- * shift `b' left the appropriate amount and add it to the result.
- * Similarly, to divide `a' by `b', we shift `b' left varying amounts,
- * repeatedly trying to subtract it from `a'.  When we succeed, we note
- * the fact by setting a bit in the quotient.  While these algorithms
+ * and `b', we zeroed out the result.  Then, for each `1' bit in `a', we
+ * shifted `b' left the appropriate amount and added it to the result.
+ * Similarly, to divide `a' by `b', we shifted `b' left varying amounts,
+ * repeatedly trying to subtract it from `a'.  When we succeeded, we noted
+ * the fact by setting a bit in the quotient.  (Both have since moved to
+ * the word-level methods described below.)  While these algorithms
  * have the same O(n^2) time complexity as Knuth's, the ``constant factor''
  * is likely to be larger.
  *
- * Because I used these algorithms, which require single-block addition
- * and subtraction rather than single-block multiplication and division,
- * the innermost loops of all four routines are very similar.  Study one
- * of them and all will become clear.
+ * The addition and subtraction routines carried one bit at a time
+ * through comparisons; they now use the kernels above.
  */
 
 /*
- * This is a little inline function used by both the multiplication
- * routine and the division routine.
- *
- * `getShiftedBlock' returns the `x'th block of `num << y'.
- * `y' may be anything from 0 to N - 1, and `x' may be anything from
- * 0 to `num.len'.
- *
- * Two things contribute to this block:
- *
- * (1) The `N - y' low bits of `num.blk[x]', shifted `y' bits left.
+ * WORD-LEVEL MULTIPLICATION AND DIVISION
+ * Multiplication and division now take Knuth's advice: the compiler's
+ * double-width integer (or, without one, arithmetic on half-blocks) gives
+ * us `b_0' and `c_0', so the schoolbook method multiplies and Algorithm D
+ * divides a whole block at a time.  Large products are split further:
+ * Karatsuba's method trades one of four half-size products for a few
+ * additions, and Toom-3 five ninths of the work for an interpolation.
+ * Huge ones go through a number-theoretic transform.
  *
- * (2) The `y' high bits of `num.blk[x-1]', shifted `N - y' bits right.
- *
- * But we must be careful if `x == 0' or `x == num.len', in
- * which case we should use 0 instead of (2) or (1), respectively.
+ * The kernels below work on raw block arrays, least significant block
+ * first.  A product of `na' and `nb' blocks is written to `na + nb' blocks
+ * of `r', which must not overlap either operand.
+ */
+
+// These defaults were measured on x86-64 with 64-bit blocks.
+Index BigUnsigned::karatsubaThreshold = 24;
+Index BigUnsigned::toom3Threshold = 240;
+Index BigUnsigned::nttThreshold = 4096;
+Index BigUnsigned::parallelThreshold = 512;
+Index BigUnsigned::divisionThreshold = 40;
+
+/*
+ * Divides the two-block number `high:low' by `d', which must have its top
+ * bit set and exceed `high', so that the quotient fits in a block (this is
+ * Knuth's `c_0').  Returns the quotient and sets `remainder'.
+ */
+static inline Blk divideBlock(Blk high, Blk low, Blk d, Blk &remainder) {
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 u = ((unsigned __int128)high << blockBits) | low;
+	Blk quotient = Blk(u / d);
+	remainder = Blk(u - (unsigned __int128)quotient * d);
+	return quotient;
+#else
+	/* Schoolbook division of four half-blocks by two, as in Hacker's
+	 * Delight's `divlu'.  Each quotient half-block estimate is off by at
+	 * most two. */
+	const unsigned int h = blockBits / 2;
+	const Blk base = Blk(1) << h, mask = base - 1;
+	Blk d1 = d >> h, d0 = d & mask;
+	Blk u1 = low >> h, u0 = low & mask;
+	Blk q1 = high / d1, rhat = high - q1 * d1;
+	while (q1 >= base || q1 * d0 > ((rhat << h) | u1)) {
+		q1--;
+		rhat += d1;
+		if (rhat >= base)
+			break;
+	}
+	Blk middle = (high << h) + u1 - q1 * d;
+	Blk q0 = middle / d1;
+	rhat = middle - q0 * d1;
+	while (q0 >= base || q0 * d0 > ((rhat << h) | u0)) {
+		q0--;
+		rhat += d1;
+		if (rhat >= base)
+			break;
+	}
+	remainder = (middle << h) + u0 - q0 * d;
+	return (q1 << h) | q0;
+#endif
+}
+
+// Returns the number of leading zero bits of `x', which must be nonzero.
+static inline unsigned int leadingZeros(Blk x) {
+#ifdef __GNUC__
+	return __builtin_clzl(x);
+#else
+	unsigned int n = 0;
+	while ((x & (Blk(1) << (blockBits - 1))) == 0) {
+		x <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+static void multiplyBlocks(Blk *r, const Blk *a, Index na, const Blk *b, Index nb);
+
+static void multiplySchoolbook(Blk *r, const Blk *a, Index na, const Blk *b, Index nb) {
+	Index i, j;
+	for (j = 0; j < nb; j++)
+		r[j] = 0;
+	/* Row `i' adds `a[i] * b' to r[i..i+nb] and is the first to write
+	 * r[i+nb], so only the first `nb' blocks need zeroing. */
+	for (i = 0; i < na; i++) {
+		Blk carry = 0;
+		for (j = 0; j < nb; j++)
+			r[i + j] = multiplyAdd(a[i], b[j], r[i + j], carry, carry);
+		r[i + nb] = carry;
+	}
+}
+
+/*
+ * Operands of very different sizes: multiply `b' by `nb'-block slices of
+ * `a' and add up the products.  Requires na >= nb.
+ */
+static void multiplyUnbalanced(Blk *r, const Blk *a, Index na, const Blk *b, Index nb) {
+	Index n = na + nb, i;
+	Blk *product = new Blk[2 * nb];
+	for (i = 0; i < n; i++)
+		r[i] = 0;
+	for (i = 0; i < na; i += nb) {
+		Index slice = (na - i < nb) ? na - i : nb;
+		multiplyBlocks(product, a + i, slice, b, nb);
+		addBlocks(r + i, r + i, n - i, product, slice + nb);
+	}
+	delete [] product;
+}
+
+/*
+ * Karatsuba's method.  With a = a1 X + a0 and b = b1 X + b0, where X is a
+ * power of the block base,
+ *     ab = a1 b1 X^2 + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) X + a0 b0,
+ * which needs three products instead of four.  All the intermediate values
+ * are nonnegative.  Requires na >= nb > na / 2, so that `b1' isn't empty.
+ */
+static void multiplyKaratsuba(Blk *r, const Blk *a, Index na, const Blk *b, Index nb) {
+	Index m = na / 2, n = na + nb;
+	Index ha = na - m, hb = nb - m;
+	Index nsa = ha + 1, nsb = (hb > m ? hb : m) + 1, nmid = nsa + nsb;
+	Blk *sa = new Blk[nsa + nsb + nmid];
+	Blk *sb = sa + nsa, *mid = sb + nsb;
+	// a0 + a1 and b0 + b1.  `a1' is at least as long as `a0'.
+	sa[ha] = addBlocks(sa, a + m, ha, a, m);
+	if (hb >= m)
+		sb[hb] = addBlocks(sb, b + m, hb, b, m);
+	else
+		sb[m] = addBlocks(sb, b, m, b + m, hb);
+	// a0 b0 and a1 b1 go straight to their places in the result.
+	WorkerPool::run(nb >= BigUnsigned::parallelThreshold,
+		[=] { multiplyBlocks(mid, sa, nsa, sb, nsb); },
+		[=] { multiplyBlocks(r, a, m, b, m); },
+		[=] { multiplyBlocks(r + 2 * m, a + m, ha, b + m, hb); });
+	subtractBlocks(mid, mid, nmid, r, 2 * m);
+	subtractBlocks(mid, mid, nmid, r + 2 * m, n - 2 * m);
+	// The middle term fits in n - m blocks; any block of `mid' past that is 0.
+	addBlocks(r + m, r + m, n - m, mid, (nmid < n - m) ? nmid : n - m);
+	delete [] sa;
+}
+
+/*
+ * Toom-3 needs signed intermediate values.  A `ToomTerm' is a sign and a
+ * magnitude without leading zero blocks.
+ */
+struct ToomTerm {
+	std::vector<Blk> mag;
+	bool negative;
+
+	ToomTerm() : negative(false) {}
+	ToomTerm(const Blk *b, Index n) : mag(b, b + n), negative(false) {
+		trim();
+	}
+
+	void trim() {
+		while (!mag.empty() && mag.back() == 0)
+			mag.pop_back();
+		if (mag.empty())
+			negative = false;
+	}
+};
+
+static int compareMagnitudes(const ToomTerm &x, const ToomTerm &y) {
+	if (x.mag.size() != y.mag.size())
+		return x.mag.size() < y.mag.size() ? -1 : 1;
+	for (Index i = Index(x.mag.size()); i-- > 0; )
+		if (x.mag[i] != y.mag[i])
+			return x.mag[i] < y.mag[i] ? -1 : 1;
+	return 0;
+}
+
+// Returns x + y, or x - y if `subtract' is set.
+static ToomTerm addTerms(const ToomTerm &x, const ToomTerm &y, bool subtract = false) {
+	bool yNegative = (y.negative != subtract) && !y.mag.empty();
+	ToomTerm z;
+	if (x.negative == yNegative) {
+		const ToomTerm &big = x.mag.size() >= y.mag.size() ? x : y;
+		const ToomTerm &small = x.mag.size() >= y.mag.size() ? y : x;
+		if (big.mag.empty())
+			return z;
+		Index n = Index(big.mag.size());
+		z.mag.resize(n + 1);
+		z.mag[n] = addBlocks(&z.mag[0], &big.mag[0], n,
+			small.mag.empty() ? NULL : &small.mag[0], Index(small.mag.size()));
+		z.negative = x.negative;
+	} else {
+		int cmp = compareMagnitudes(x, y);
+		const ToomTerm &big = cmp >= 0 ? x : y;
+		const ToomTerm &small = cmp >= 0 ? y : x;
+		if (big.mag.empty())
+			return z;
+		z.mag.resize(big.mag.size());
+		subtractBlocks(&z.mag[0], &big.mag[0], Index(big.mag.size()),
+			small.mag.empty() ? NULL : &small.mag[0], Index(small.mag.size()));
+		z.negative = cmp >= 0 ? x.negative : yNegative;
+	}
+	z.trim();
+	return z;
+}
+
+static ToomTerm multiplyTerms(const ToomTerm &x, const ToomTerm &y) {
+	ToomTerm z;
+	if (x.mag.empty() || y.mag.empty())
+		return z;
+	Index nx = Index(x.mag.size()), ny = Index(y.mag.size());
+	z.mag.resize(nx + ny);
+	multiplyBlocks(&z.mag[0], &x.mag[0], nx, &y.mag[0], ny);
+	z.negative = x.negative != y.negative;
+	z.trim();
+	return z;
+}
+
+static void doubleTerm(ToomTerm &x) {
+	Blk carry = 0;
+	for (Index i = 0; i < x.mag.size(); i++) {
+		Blk next = x.mag[i] >> (blockBits - 1);
+		x.mag[i] = (x.mag[i] << 1) | carry;
+		carry = next;
+	}
+	if (carry != 0)
+		x.mag.push_back(carry);
+}
+
+// Halves `x', which must be even.
+static void halveTerm(ToomTerm &x) {
+	Blk carry = 0;
+	for (Index i = Index(x.mag.size()); i-- > 0; ) {
+		Blk next = x.mag[i] << (blockBits - 1);
+		x.mag[i] = (x.mag[i] >> 1) | carry;
+		carry = next;
+	}
+	x.trim();
+}
+
+/* Divides `x', which must be a multiple of 3, by 3.  Each block is divided
+ * in two halves so that the partial dividend fits in a block. */
+static void divideTermBy3(ToomTerm &x) {
+	const unsigned int h = blockBits / 2;
+	const Blk mask = (Blk(1) << h) - 1;
+	Blk remainder = 0;
+	for (Index i = Index(x.mag.size()); i-- > 0; ) {
+		Blk high = (remainder << h) | (x.mag[i] >> h);
+		remainder = high % 3;
+		Blk low = (remainder << h) | (x.mag[i] & mask);
+		remainder = low % 3;
+		x.mag[i] = ((high / 3) << h) | (low / 3);
+	}
+	x.trim();
+}
+
+/*
+ * Toom-3, with Bodrato's evaluation and interpolation sequence.  Both
+ * operands are cut into three k-block pieces, a = a2 X^2 + a1 X + a0 with
+ * X = B^k, seen as polynomials evaluated at 0, 1, -1, -2 and infinity.  The
+ * five pointwise products determine the product polynomial, whose
+ * coefficients are added into place.  Requires na >= nb > na / 2.
+ */
+static void multiplyToom3(Blk *r, const Blk *a, Index na, const Blk *b, Index nb) {
+	Index k = (na + 2) / 3, n = na + nb, i;
+	ToomTerm a0(a, k), a1(a + k, k), a2(a + 2 * k, na - 2 * k);
+	ToomTerm b0(b, k), b1, b2;
+	if (nb > k)
+		b1 = ToomTerm(b + k, (nb - k < k) ? nb - k : k);
+	if (nb > 2 * k)
+		b2 = ToomTerm(b + 2 * k, nb - 2 * k);
+
+	// a(1), a(-1), a(-2), and likewise for b.
+	ToomTerm p = addTerms(a0, a2);
+	ToomTerm aPlus1 = addTerms(p, a1), aMinus1 = addTerms(p, a1, true);
+	ToomTerm aMinus2 = addTerms(aMinus1, a2);
+	doubleTerm(aMinus2);
+	aMinus2 = addTerms(aMinus2, a0, true);
+	p = addTerms(b0, b2);
+	ToomTerm bPlus1 = addTerms(p, b1), bMinus1 = addTerms(p, b1, true);
+	ToomTerm bMinus2 = addTerms(bMinus1, b2);
+	doubleTerm(bMinus2);
+	bMinus2 = addTerms(bMinus2, b0, true);
+
+	ToomTerm r0, r1, rMinus1, rMinus2, r4;
+	WorkerPool::run(nb >= BigUnsigned::parallelThreshold,
+		[&] { r0 = multiplyTerms(a0, b0); },
+		[&] { r1 = multiplyTerms(aPlus1, bPlus1); },
+		[&] { rMinus1 = multiplyTerms(aMinus1, bMinus1); },
+		[&] { rMinus2 = multiplyTerms(aMinus2, bMinus2); },
+		[&] { r4 = multiplyTerms(a2, b2); });
+
+	ToomTerm r3 = addTerms(rMinus2, r1, true);
+	divideTermBy3(r3);
+	r1 = addTerms(r1, rMinus1, true);
+	halveTerm(r1);
+	ToomTerm r2 = addTerms(rMinus1, r0, true);
+	r3 = addTerms(r2, r3, true);
+	halveTerm(r3);
+	ToomTerm twiceR4 = r4;
+	doubleTerm(twiceR4);
+	r3 = addTerms(r3, twiceR4);
+	r2 = addTerms(addTerms(r2, r1), r4, true);
+	r1 = addTerms(r1, r3, true);
+
+	// The coefficients are now all nonnegative.
+	const ToomTerm *coefficients[] = { &r0, &r1, &r2, &r3, &r4 };
+	for (i = 0; i < n; i++)
+		r[i] = 0;
+	for (i = 0; i < 5; i++) {
+		const std::vector<Blk> &c = coefficients[i]->mag;
+		if (!c.empty())
+			addBlocks(r + i * k, r + i * k, n - i * k, &c[0], Index(c.size()));
+	}
+}
+
+#ifdef __SIZEOF_INT128__
+/*
+ * Number-theoretic transform multiplication, for operands so big that even
+ * Toom-3 is slow.  The blocks of each operand are the coefficients of a
+ * polynomial, and the product's coefficients are their convolution, which
+ * a transform computes in O(n log n): transform both, multiply pointwise,
+ * transform back.  The transform is a discrete Fourier transform modulo a
+ * prime p = c 2^k + 1, where 2^k-th roots of unity exist.
  *
- * If `y == 0', then (2) contributes 0, as it should.  However,
- * in some computer environments, for a reason I cannot understand,
- * `a >> b' means `a >> (b % N)'.  This means `num.blk[x-1] >> (N - y)'
- * will return `num.blk[x-1]' instead of the desired 0 when `y == 0';
- * the test `y == 0' handles this case specially.
+ * A convolution coefficient is less than n 2^128, so it is computed modulo
+ * three primes just under 2^63, whose product exceeds 2^183, and recovered
+ * from the residues with the Chinese remainder theorem (in Garner's form).
+ * Arithmetic modulo each prime is in Montgomery form.
+ */
+typedef unsigned __int128 Wide;
+
+struct NttPrime {
+	uint64_t p;
+	// The primitive root
+	uint64_t generator;
+	// -1/p modulo 2^64, and 2^128 modulo p
+	uint64_t negInverse, r2;
+
+	NttPrime(uint64_t p, uint64_t generator) : p(p), generator(generator) {
+		uint64_t inverse = p; // Correct to 3 bits; each step doubles that.
+		for (int i = 0; i < 5; i++)
+			inverse *= 2 - p * inverse;
+		negInverse = 0 - inverse;
+		uint64_t r = uint64_t((Wide(1) << 64) % p);
+		r2 = uint64_t(Wide(r) * r % p);
+	}
+
+	// Montgomery reduction: t / 2^64 modulo p, for t < p 2^64.
+	uint64_t reduce(Wide t) const {
+		uint64_t m = uint64_t(t) * negInverse;
+		uint64_t u = uint64_t((t + Wide(m) * p) >> 64);
+		return u >= p ? u - p : u;
+	}
+	uint64_t multiply(uint64_t a, uint64_t b) const { return reduce(Wide(a) * b); }
+	uint64_t add(uint64_t a, uint64_t b) const {
+		uint64_t s = a + b;
+		return s >= p ? s - p : s;
+	}
+	uint64_t subtract(uint64_t a, uint64_t b) const { return a >= b ? a - b : a + p - b; }
+	uint64_t toMontgomery(uint64_t x) const { return multiply(x % p, r2); }
+	uint64_t power(uint64_t base, uint64_t exponent) const {
+		uint64_t result = toMontgomery(1);
+		for (; exponent != 0; exponent >>= 1) {
+			if (exponent & 1)
+				result = multiply(result, base);
+			base = multiply(base, base);
+		}
+		return result;
+	}
+};
+
+static const NttPrime nttPrimes[3] = {
+	NttPrime(29ull * (1ull << 57) + 1, 3),
+	NttPrime(69ull * (1ull << 55) + 1, 5),
+	NttPrime(27ull * (1ull << 56) + 1, 5)
+};
+
+/*
+ * The transforms use a table of n roots of unity, laid out by level: for
+ * each power of two h < n, roots[h..2h) holds w^0 .. w^(h-1) for a
+ * primitive 2h-th root w, so that each pass reads its roots contiguously.
  */
-inline BigUnsigned::Blk getShiftedBlock(const BigUnsigned &num,
-	BigUnsigned::Index x, unsigned int y) {
-	BigUnsigned::Blk part1 = (x == 0 || y == 0) ? 0 : (num.blk[x - 1] >> (BigUnsigned::N - y));
-	BigUnsigned::Blk part2 = (x == num.len) ? 0 : (num.blk[x] << y);
-	return part1 | part2;
+static void computeRoots(uint64_t *roots, Index n, uint64_t root, const NttPrime &m) {
+	Index h = n / 2, j;
+	uint64_t w = m.toMontgomery(1);
+	for (j = 0; j < h; j++) {
+		roots[h + j] = w;
+		w = m.multiply(w, root);
+	}
+	for (h /= 2; h >= 1; h /= 2)
+		for (j = 0; j < h; j++)
+			roots[h + j] = roots[2 * (h + j)];
+}
+
+/* Decimation in frequency: transforms `a' in place, leaving the result in
+ * bit-reversed order. */
+static void nttForward(uint64_t *a, Index n, const uint64_t *roots, const NttPrime &m) {
+	for (Index half = n / 2; half >= 1; half /= 2) {
+		const uint64_t *w = roots + half;
+		for (Index i = 0; i < n; i += 2 * half)
+			for (Index j = 0; j < half; j++) {
+				uint64_t u = a[i + j], v = a[i + j + half];
+				a[i + j] = m.add(u, v);
+				a[i + j + half] = m.multiply(m.subtract(u, v), w[j]);
+			}
+	}
+}
+
+/* Decimation in time, from bit-reversed order back to natural order.  With
+ * a table of inverse roots this undoes `nttForward', up to a factor of n. */
+static void nttInverse(uint64_t *a, Index n, const uint64_t *roots, const NttPrime &m) {
+	for (Index half = 1; half < n; half *= 2) {
+		const uint64_t *w = roots + half;
+		for (Index i = 0; i < n; i += 2 * half)
+			for (Index j = 0; j < half; j++) {
+				uint64_t u = a[i + j], v = m.multiply(a[i + j + half], w[j]);
+				a[i + j] = m.add(u, v);
+				a[i + j + half] = m.subtract(u, v);
+			}
+	}
+}
+
+/* Sets `c' to the cyclic convolution of a and b, of length n, modulo one
+ * prime.  `b' may be `a' (with nb == na), which saves a transform when
+ * squaring.  `scratch' has room for 2n values.  With `parallel', the
+ * operands are transformed at the same time.
+ *
+ * The blocks go in merely reduced, so to the Montgomery arithmetic they
+ * stand for x / 2^64; the factor that brings the product back is folded
+ * into the final division by n. */
+static void convolveModulo(uint64_t *c, uint64_t *scratch, const Blk *a, Index na,
+		const Blk *b, Index nb, Index n, const NttPrime &m, bool parallel) {
+	Index i;
+	uint64_t *roots = scratch + n;
+	uint64_t root = m.power(m.toMontgomery(m.generator), (m.p - 1) / n);
+
+	computeRoots(roots, n, root, m);
+	auto transform = [=, &m](uint64_t *t, const Blk *x, Index nx) {
+		Index j;
+		for (j = 0; j < nx; j++)
+			t[j] = x[j] % m.p;
+		for (; j < n; j++)
+			t[j] = 0;
+		nttForward(t, n, roots, m);
+	};
+	if (a == b && na == nb) {
+		transform(c, a, na);
+		for (i = 0; i < n; i++)
+			c[i] = m.multiply(c[i], c[i]);
+	} else {
+		WorkerPool::run(parallel,
+			[&] { transform(c, a, na); },
+			[&] { transform(scratch, b, nb); });
+		for (i = 0; i < n; i++)
+			c[i] = m.multiply(c[i], scratch[i]);
+	}
+	computeRoots(roots, n, m.power(root, n - 1), m);
+	nttInverse(c, n, roots, m);
+
+	// c[i] now stands for the coefficient times n / 2^128.
+	uint64_t scale = m.multiply(m.power(m.toMontgomery(n), m.p - 2), m.r2);
+	for (i = 0; i < n; i++)
+		c[i] = m.multiply(c[i], scale);
+}
+
+static void multiplyNtt(Blk *r, const Blk *a, Index na, const Blk *b, Index nb) {
+	Index coefficients = na + nb - 1, n = 1, i;
+	while (n < coefficients)
+		n <<= 1;
+	// For each prime, the residues and 2n values of scratch space
+	std::vector<uint64_t> space(9 * size_t(n));
+	uint64_t *c[3], *scratch[3];
+	for (i = 0; i < 3; i++) {
+		c[i] = &space[3 * i * size_t(n)];
+		scratch[i] = c[i] + n;
+	}
+	bool parallel = nb >= BigUnsigned::parallelThreshold;
+	WorkerPool::run(parallel,
+		[&] { convolveModulo(c[0], scratch[0], a, na, b, nb, n, nttPrimes[0], parallel); },
+		[&] { convolveModulo(c[1], scratch[1], a, na, b, nb, n, nttPrimes[1], parallel); },
+		[&] { convolveModulo(c[2], scratch[2], a, na, b, nb, n, nttPrimes[2], parallel); });
+
+	/* Garner's constants, in Montgomery form so that multiplying a plain
+	 * residue by one gives a plain result. */
+	const NttPrime &m2 = nttPrimes[1], &m3 = nttPrimes[2];
+	const uint64_t p1 = nttPrimes[0].p, p2 = m2.p, p3 = m3.p;
+	const uint64_t p1InverseModP2 = m2.power(m2.toMontgomery(p1), p2 - 2);
+	const uint64_t p1InverseModP3 = m3.power(m3.toMontgomery(p1), p3 - 2);
+	const uint64_t p2InverseModP3 = m3.power(m3.toMontgomery(p2), p3 - 2);
+	// The part of the sum so far that lies above the blocks already written
+	uint64_t carry0 = 0, carry1 = 0;
+	for (i = 0; i < coefficients; i++) {
+		/* x = v1 + p1 (v2 + p2 v3), where v1 = x mod p1, v2 < p2 and
+		 * v3 < p3 are chosen to match the other residues. */
+		uint64_t v1 = c[0][i];
+		uint64_t v2 = m2.multiply(m2.subtract(c[1][i], v1 % p2), p1InverseModP2);
+		uint64_t v3 = m3.multiply(m3.subtract(c[2][i], v1 % p3), p1InverseModP3);
+		v3 = m3.multiply(m3.subtract(v3, v2 % p3), p2InverseModP3);
+		Wide upper = Wide(p2) * v3 + v2;
+		Wide low = Wide(p1) * uint64_t(upper) + v1;
+		Wide high = Wide(p1) * uint64_t(upper >> 64) + uint64_t(low >> 64);
+		// Add x to the carry and write out its lowest block.
+		Wide sum = Wide(uint64_t(low)) + carry0;
+		r[i] = Blk(sum);
+		sum = Wide(uint64_t(high)) + carry1 + uint64_t(sum >> 64);
+		carry0 = uint64_t(sum);
+		carry1 = uint64_t(high >> 64) + uint64_t(sum >> 64);
+	}
+	// The product fits in na + nb blocks, so carry1 is 0 by now.
+	r[coefficients] = Blk(carry0);
+}
+#endif
+
+/* Picks an algorithm by operand size.  The thresholds are clamped so that
+ * each recursion works on strictly smaller operands. */
+static void multiplyBlocks(Blk *r, const Blk *a, Index na, const Blk *b, Index nb) {
+	if (na < nb) {
+		std::swap(a, b);
+		std::swap(na, nb);
+	}
+	Index karatsuba = BigUnsigned::karatsubaThreshold < 4 ? 4 : BigUnsigned::karatsubaThreshold;
+	Index toom3 = BigUnsigned::toom3Threshold < 5 ? 5 : BigUnsigned::toom3Threshold;
+	if (nb < karatsuba)
+		multiplySchoolbook(r, a, na, b, nb);
+#ifdef __SIZEOF_INT128__
+	// The transform takes blocks of at most 64 bits as coefficients.
+	else if (sizeof(Blk) <= sizeof(uint64_t) && nb >= BigUnsigned::nttThreshold)
+		multiplyNtt(r, a, na, b, nb);
+#endif
+	else if (nb <= na / 2)
+		multiplyUnbalanced(r, a, na, b, nb);
+	else if (nb < toom3)
+		multiplyKaratsuba(r, a, na, b, nb);
+	else
+		multiplyToom3(r, a, na, b, nb);
 }
 
 void BigUnsigned::multiply(const BigUnsigned &a, const BigUnsigned &b) {
@@ -304,65 +837,10 @@ void BigUnsigned::multiply(const BigUnsigned &a, const BigUnsigned &b) {
 		len = 0;
 		return;
 	}
-	/*
-	 * Overall method:
-	 *
-	 * Set this = 0.
-	 * For each 1-bit of `a' (say the `i2'th bit of block `i'):
-	 *    Add `b << (i blocks and i2 bits)' to *this.
-	 */
-	// Variables for the calculation
-	Index i, j, k;
-	unsigned int i2;
-	Blk temp;
-	bool carryIn, carryOut;
 	// Set preliminary length and make room
 	len = a.len + b.len;
 	allocate(len);
-	// Zero out this object
-	for (i = 0; i < len; i++)
-		blk[i] = 0;
-	// For each block of the first number...
-	for (i = 0; i < a.len; i++) {
-		// For each 1-bit of that block...
-		for (i2 = 0; i2 < N; i2++) {
-			if ((a.blk[i] & (Blk(1) << i2)) == 0)
-				continue;
-			/*
-			 * Add b to this, shifted left i blocks and i2 bits.
-			 * j is the index in b, and k = i + j is the index in this.
-			 *
-			 * `getShiftedBlock', a short inline function defined above,
-			 * is now used for the bit handling.  It replaces the more
-			 * complex `bHigh' code, in which each run of the loop dealt
-			 * immediately with the low bits and saved the high bits to
-			 * be picked up next time.  The last run of the loop used to
-			 * leave leftover high bits, which were handled separately.
-			 * Instead, this loop runs an additional time with j == b.len.
-			 * These changes were made on 2005.01.11.
-			 */
-			for (j = 0, k = i, carryIn = false; j <= b.len; j++, k++) {
-				/*
-				 * The body of this loop is very similar to the body of the first loop
-				 * in `add', except that this loop does a `+=' instead of a `+'.
-				 */
-				temp = blk[k] + getShiftedBlock(b, j, i2);
-				carryOut = (temp < blk[k]);
-				if (carryIn) {
-					temp++;
-					carryOut |= (temp == 0);
-				}
-				blk[k] = temp;
-				carryIn = carryOut;
-			}
-			// No more extra iteration to deal with `bHigh'.
-			// Roll-over a carry as necessary.
-			for (; carryIn; k++) {
-				blk[k]++;
-				carryIn = (blk[k] == 0);
-			}
-		}
-	}
+	multiplyBlocks(blk, a.blk, a.len, b.blk, b.len);
 	// Zap possible leading zero
 	if (blk[len - 1] == 0)
 		len--;
@@ -370,11 +848,11 @@ void BigUnsigned::multiply(const BigUnsigned &a, const BigUnsigned &b) {
 
 /*
  * DIVISION WITH REMAINDER
- * This monstrous function mods *this by the given divisor b while storing the
+ * This function mods *this by the given divisor b while storing the
  * quotient in the given object q; at the end, *this contains the remainder.
  * The seemingly bizarre pattern of inputs and outputs was chosen so that the
- * function copies as little as possible (since it is implemented by repeated
- * subtraction of multiples of b from *this).
+ * function copies as little as possible (since it works by subtracting
+ * multiples of b from *this in place).
  * 
  * "modWithQuotient" might be a better name for this function, but I would
  * rather not change the name now.
@@ -420,121 +898,245 @@ void BigUnsigned::divideWithRemainder(const BigUnsigned &b, BigUnsigned &q) {
 
 	// At this point we know (*this).len >= b.len > 0.  (Whew!)
 
+	Index recursive = divisionThreshold < 2 ? 2 : divisionThreshold;
+	if (b.len >= recursive && len - b.len >= recursive) {
+		divideLong(b, q);
+		return;
+	}
+
 	/*
-	 * Overall method:
-	 *
-	 * For each appropriate i and i2, decreasing:
-	 *    Subtract (b << (i blocks and i2 bits)) from *this, storing the
-	 *      result in subtractBuf.
-	 *    If the subtraction succeeds with a nonnegative result:
-	 *        Turn on bit i2 of block i of the quotient q.
-	 *        Copy subtractBuf back into *this.
-	 *    Otherwise bit i2 of block i remains off, and *this is unchanged.
-	 * 
-	 * Eventually q will contain the entire quotient, and *this will
-	 * be left with the remainder.
-	 *
-	 * subtractBuf[x] corresponds to blk[x], not blk[x+i], since 2005.01.11.
-	 * But on a single iteration, we don't touch the i lowest blocks of blk
-	 * (and don't use those of subtractBuf) because these blocks are
-	 * unaffected by the subtraction: we are subtracting
-	 * (b << (i blocks and i2 bits)), which ends in at least `i' zero
-	 * blocks. */
-	// Variables for the calculation
-	Index i, j, k;
-	unsigned int i2;
-	Blk temp;
-	bool borrowIn, borrowOut;
+	 * Both paths below first shift the divisor left until its top bit is
+	 * set, and the dividend by the same amount.  This doesn't change the
+	 * quotient, scales the remainder, and makes a two-block by one-block
+	 * division estimate each quotient block well.
+	 */
+	Index i, j;
+	unsigned int shift = leadingZeros(b.blk[b.len - 1]);
+
+	if (b.len == 1) {
+		/*
+		 * A single-block divisor: plain short division, one block of the
+		 * quotient per step.  The shifted dividend is produced on the fly.
+		 */
+		Blk d = b.blk[0] << shift;
+		Blk remainder = (shift == 0) ? 0 : blk[len - 1] >> (N - shift);
+		q.len = len;
+		q.allocate(q.len);
+		for (i = len; i-- > 0; ) {
+			Blk next = blk[i] << shift;
+			if (shift != 0 && i > 0)
+				next |= blk[i - 1] >> (N - shift);
+			q.blk[i] = divideBlock(remainder, next, d, remainder);
+		}
+		if (q.blk[q.len - 1] == 0)
+			q.len--;
+		len = (remainder == 0) ? 0 : 1;
+		blk[0] = remainder >> shift;
+		return;
+	}
 
 	/*
-	 * Make sure we have an extra zero block just past the value.
+	 * Knuth's Algorithm D (Section 4.3.1).  For each quotient block from
+	 * the top, estimate it from the top two blocks of the current partial
+	 * remainder and the top block of the divisor, refine the estimate with
+	 * the divisor's second block (after which it is at most one too big),
+	 * then subtract that multiple of the divisor.  If the subtraction
+	 * goes negative, the estimate was one too big: add the divisor back.
 	 *
-	 * When we attempt a subtraction, we might shift `b' so
-	 * its first block begins a few bits left of the dividend,
-	 * and then we'll try to compare these extra bits with
-	 * a nonexistent block to the left of the dividend.  The
-	 * extra zero block ensures sensible behavior; we need
-	 * an extra block in `subtractBuf' for exactly the same reason.
+	 * The dividend is normalized in place, in one extra block.  The
+	 * divisor is only copied when it actually needs shifting, and onto the
+	 * stack when it is small.
 	 */
-	Index origLen = len; // Save real length.
-	/* To avoid an out-of-bounds access in case of reallocation, allocate
-	 * first and then increment the logical length. */
+	Index n = b.len, m = len - n;
 	allocateAndCopy(len + 1);
-	len++;
-	blk[origLen] = 0; // Zero the added block.
-
-	// subtractBuf holds part of the result of a subtraction; see above.
-	Blk *subtractBuf = new Blk[len];
+	blk[len] = (shift == 0) ? 0 : blk[len - 1] >> (N - shift);
+	for (i = len; i-- > 0; )
+		blk[i] = (shift == 0 || i == 0) ? blk[i] << shift
+			: (blk[i] << shift) | (blk[i - 1] >> (N - shift));
+	Blk normalizedStorage[inlineCapacity];
+	Blk *normalizedB = (shift == 0) ? NULL
+		: (n <= inlineCapacity) ? normalizedStorage : new Blk[n];
+	const Blk *v = b.blk;
+	if (normalizedB != NULL) {
+		for (i = n; i-- > 0; )
+			normalizedB[i] = (i == 0) ? b.blk[i] << shift
+				: (b.blk[i] << shift) | (b.blk[i - 1] >> (N - shift));
+		v = normalizedB;
+	}
 
-	// Set preliminary length for quotient and make room
-	q.len = origLen - b.len + 1;
+	q.len = m + 1;
 	q.allocate(q.len);
-	// Zero out the quotient
-	for (i = 0; i < q.len; i++)
-		q.blk[i] = 0;
-
-	// For each possible left-shift of b in blocks...
-	i = q.len;
-	while (i > 0) {
-		i--;
-		// For each possible left-shift of b in bits...
-		// (Remember, N is the number of bits in a Blk.)
-		q.blk[i] = 0;
-		i2 = N;
-		while (i2 > 0) {
-			i2--;
-			/*
-			 * Subtract b, shifted left i blocks and i2 bits, from *this,
-			 * and store the answer in subtractBuf.  In the for loop, `k == i + j'.
-			 *
-			 * Compare this to the middle section of `multiply'.  They
-			 * are in many ways analogous.  See especially the discussion
-			 * of `getShiftedBlock'.
-			 */
-			for (j = 0, k = i, borrowIn = false; j <= b.len; j++, k++) {
-				temp = blk[k] - getShiftedBlock(b, j, i2);
-				borrowOut = (temp > blk[k]);
-				if (borrowIn) {
-					borrowOut |= (temp == 0);
-					temp--;
-				}
-				// Since 2005.01.11, indices of `subtractBuf' directly match those of `blk', so use `k'.
-				subtractBuf[k] = temp; 
-				borrowIn = borrowOut;
-			}
-			// No more extra iteration to deal with `bHigh'.
-			// Roll-over a borrow as necessary.
-			for (; k < origLen && borrowIn; k++) {
-				borrowIn = (blk[k] == 0);
-				subtractBuf[k] = blk[k] - 1;
-			}
-			/*
-			 * If the subtraction was performed successfully (!borrowIn),
-			 * set bit i2 in block i of the quotient.
-			 *
-			 * Then, copy the portion of subtractBuf filled by the subtraction
-			 * back to *this.  This portion starts with block i and ends--
-			 * where?  Not necessarily at block `i + b.len'!  Well, we
-			 * increased k every time we saved a block into subtractBuf, so
-			 * the region of subtractBuf we copy is just [i, k).
-			 */
-			if (!borrowIn) {
-				q.blk[i] |= (Blk(1) << i2);
-				while (k > i) {
-					k--;
-					blk[k] = subtractBuf[k];
-				}
-			} 
+	Blk vTop = v[n - 1], vNext = v[n - 2];
+	for (j = m + 1; j-- > 0; ) {
+		Blk *u = blk + j;
+		// Estimate this quotient block.
+		Blk qhat, rhat;
+		bool rhatOverflow = false;
+		if (u[n] >= vTop) {
+			// Only possible when u[n] == vTop; the quotient block is at most B - 1.
+			qhat = ~Blk(0);
+			rhat = u[n - 1] + vTop;
+			rhatOverflow = (rhat < vTop);
+		} else
+			qhat = divideBlock(u[n], u[n - 1], vTop, rhat);
+		while (!rhatOverflow) {
+			Blk productHigh, productLow = multiplyAdd(qhat, vNext, 0, 0, productHigh);
+			if (productHigh < rhat || (productHigh == rhat && productLow <= u[n - 2]))
+				break;
+			qhat--;
+			rhat += vTop;
+			rhatOverflow = (rhat < vTop);
+		}
+		// Subtract qhat * v from u[0..n].
+		Blk carry = 0, borrow = 0;
+		for (i = 0; i <= n; i++) {
+			Blk product = (i < n) ? multiplyAdd(qhat, v[i], carry, 0, carry) : carry;
+			Blk x = u[i];
+			Blk y = x - product;
+			Blk newBorrow = (x < product);
+			u[i] = y - borrow;
+			borrow = newBorrow + (y < borrow);
 		}
+		if (borrow != 0) {
+			qhat--;
+			addBlocks(u, u, n + 1, v, n);
+		}
+		q.blk[j] = qhat;
 	}
 	// Zap possible leading zero in quotient
 	if (q.blk[q.len - 1] == 0)
 		q.len--;
-	// Zap any/all leading zeros in remainder
+	// The remainder is in the low n blocks; undo the normalization.
+	len = n;
+	for (i = 0; i < n; i++)
+		blk[i] = (shift == 0 || i + 1 == n) ? blk[i] >> shift
+			: (blk[i] >> shift) | (blk[i + 1] << (N - shift));
 	zapLeadingZeros();
-	// Deallocate subtractBuf.
-	// (Thanks to Brad Spencer for noticing my accidental omission of this!)
-	delete [] subtractBuf;
+	if (normalizedB != normalizedStorage)
+		delete [] normalizedB;
+}
+
+/*
+ * RECURSIVE DIVISION
+ * Algorithm D takes time proportional to the product of the lengths of the
+ * divisor and the quotient.  For long ones, the divisor is normalized as
+ * above and the dividend is divided a piece of at most twice the divisor's
+ * length at a time, from the top, as in long division with digits of
+ * `b.len' blocks.  Each piece is divided recursively, after Burnikel and
+ * Ziegler (see Brent and Zimmermann, "Modern Computer Arithmetic",
+ * Algorithm 1.8): its top half is divided by the divisor's top half, and
+ * the quotient so found, off by at most a little, is corrected with one
+ * multiplication by the divisor's bottom half.  A division then costs a few
+ * multiplications of its size, so it gains from Karatsuba's method and the
+ * transforms above.
+ */
+
+BigUnsigned BigUnsigned::blocksFrom(Index k) const {
+	return k >= len ? BigUnsigned() : BigUnsigned(blk + k, len - k);
+}
+
+BigUnsigned BigUnsigned::blocksBelow(Index k) const {
+	return BigUnsigned(blk, k < len ? k : len);
+}
+
+BigUnsigned BigUnsigned::blocksShifted(Index k) const {
+	if (len == 0)
+		return BigUnsigned();
+	BigUnsigned ans(0, len + k);
+	ans.len = len + k;
+	for (Index i = 0; i < k; i++)
+		ans.blk[i] = 0;
+	for (Index i = 0; i < len; i++)
+		ans.blk[k + i] = blk[i];
+	return ans;
+}
+
+void BigUnsigned::divideRecursive(const BigUnsigned &a, const BigUnsigned &b,
+		BigUnsigned &q, BigUnsigned &r) {
+	Index n = b.len, m = a.len > n ? a.len - n : 0;
+	if (m < divisionThreshold || m < 2) {
+		r = a;
+		r.divideWithRemainder(b, q);
+		return;
+	}
+
+	BigUnsigned x, y;
+	if (n > m) {
+		/* Only the top m blocks of the divisor matter much to a quotient of
+		 * m blocks, so divide by those and correct as below. */
+		Index k = n - m;
+		BigUnsigned r1;
+		divideRecursive(a.blocksFrom(k), b.blocksFrom(k), q, r1);
+		x = r1.blocksShifted(k) + a.blocksBelow(k);
+		y = q * b.blocksBelow(k);
+		while (x < y) {
+			q--;
+			x += b;
+		}
+		r = x - y;
+		return;
+	}
+
+	Index k = m / 2;
+	BigUnsigned b1(b.blocksFrom(k)), b0(b.blocksBelow(k)), q1, r1, q0, r0;
+	divideRecursive(a.blocksFrom(2 * k), b1, q1, r1);
+	// x - y is what is left of a over B^k after taking q1 b B^k from it.
+	x = r1.blocksShifted(2 * k) + a.blocksBelow(2 * k);
+	y = (q1 * b0).blocksShifted(k);
+	if (x < y) {
+		BigUnsigned shiftedB(b.blocksShifted(k));
+		do {
+			q1--;
+			x += shiftedB;
+		} while (x < y);
+	}
+	x -= y;
+
+	divideRecursive(x.blocksFrom(k), b1, q0, r0);
+	x = r0.blocksShifted(k) + x.blocksBelow(k);
+	y = q0 * b0;
+	while (x < y) {
+		q0--;
+		x += b;
+	}
+	r = x - y;
+	q = q1.blocksShifted(k) + q0;
+}
+
+void BigUnsigned::divideLong(const BigUnsigned &b, BigUnsigned &q) {
+	unsigned int shift = leadingZeros(b.blk[b.len - 1]);
+	BigUnsigned v(b << int(shift)), u(*this << int(shift)), piece, quotient, remainder;
+	Index n = v.len, m = u.len - n, i;
+
+	/* The quotient has m or m + 1 blocks.  Only the first piece's quotient
+	 * can be longer than the blocks it was brought down with, and every
+	 * other one fills exactly the blocks below the one before. */
+	q.len = m + 1;
+	q.allocate(q.len);
+	for (i = 0; i <= m; i++)
+		q.blk[i] = 0;
+	Index top = m, bottom = m > n ? m - n : 0;
+	piece = u.blocksFrom(bottom);
+	for (;;) {
+		divideRecursive(piece, v, quotient, remainder);
+		for (i = 0; i < quotient.len; i++)
+			q.blk[bottom + i] = quotient.blk[i];
+		if (bottom == 0)
+			break;
+		// Bring down the next blocks of the dividend below the remainder.
+		top = bottom;
+		bottom = top > n ? top - n : 0;
+		Index brought = top - bottom;
+		piece.len = brought + remainder.len;
+		piece.allocate(piece.len);
+		for (i = 0; i < brought; i++)
+			piece.blk[i] = u.blk[bottom + i];
+		for (i = 0; i < remainder.len; i++)
+			piece.blk[brought + i] = remainder.blk[i];
+		piece.zapLeadingZeros();
+	}
+	q.zapLeadingZeros();
+	*this = remainder >> int(shift);
 }
 
 /* BITWISE OPERATORS
@@ -603,16 +1205,24 @@ void BigUnsigned::bitShiftLeft(const BigUnsigned &a, int b) {
 			return;
 		}
 	}
+	if (a.len == 0) {
+		len = 0;
+		return;
+	}
 	Index shiftBlocks = b / N;
 	unsigned int shiftBits = b % N;
 	// + 1: room for high bits nudged left into another block
 	len = a.len + shiftBlocks + 1;
 	allocate(len);
-	Index i, j;
+	Index i;
 	for (i = 0; i < shiftBlocks; i++)
 		blk[i] = 0;
-	for (j = 0, i = shiftBlocks; j <= a.len; j++, i++)
-		blk[i] = getShiftedBlock(a, j, shiftBits);
+	if (shiftBits == 0) {
+		for (i = 0; i < a.len; i++)
+			blk[shiftBlocks + i] = a.blk[i];
+		blk[len - 1] = 0;
+	} else
+		blk[len - 1] = shiftLeftBlocks(blk + shiftBlocks, a.blk, a.len, shiftBits);
 	// Zap possible leading zero
 	if (blk[len - 1] == 0)
 		len--;
@@ -629,25 +1239,20 @@ void BigUnsigned::bitShiftRight(const BigUnsigned &a, int b) {
 			return;
 		}
 	}
-	// This calculation is wacky, but expressing the shift as a left bit shift
-	// within each block lets us use getShiftedBlock.
-	Index rightShiftBlocks = (b + N - 1) / N;
-	unsigned int leftShiftBits = N * rightShiftBlocks - b;
-	// Now (N * rightShiftBlocks - leftShiftBits) == b
-	// and 0 <= leftShiftBits < N.
-	if (rightShiftBlocks >= a.len + 1) {
-		// All of a is guaranteed to be shifted off, even considering the left
-		// bit shift.
+	Index shiftBlocks = b / N;
+	unsigned int shiftBits = b % N;
+	if (shiftBlocks >= a.len) {
+		// All of a is shifted off.
 		len = 0;
 		return;
 	}
-	// Now we're allocating a positive amount.
-	// + 1: room for high bits nudged left into another block
-	len = a.len + 1 - rightShiftBlocks;
+	len = a.len - shiftBlocks;
 	allocate(len);
-	Index i, j;
-	for (j = rightShiftBlocks, i = 0; j <= a.len; j++, i++)
-		blk[i] = getShiftedBlock(a, j, leftShiftBits);
+	if (shiftBits == 0)
+		for (Index i = 0; i < len; i++)
+			blk[i] = a.blk[shiftBlocks + i];
+	else
+		shiftRightBlocks(blk, a.blk + shiftBlocks, len, shiftBits);
 	// Zap possible leading zero
 	if (blk[len - 1] == 0)
 		len--;
@@ -24,7 +24,7 @@ public:
 
 protected:
 	// Creates a BigUnsigned with a capacity; for internal use.
-	BigUnsigned(int, Index c) : NumberlikeArray<Blk>(0, c) {}
+	BigUnsigned(int, Index c) : NumberlikeArray<Blk>(c) {}
 
 	// Decreases len to eliminate any leading zero blocks.
 	void zapLeadingZeros() { 
@@ -39,9 +39,17 @@ public:
 	// Copy constructor
 	BigUnsigned(const BigUnsigned &x) : NumberlikeArray<Blk>(x) {}
 
-	// Assignment operator
-	void operator=(const BigUnsigned &x) {
+	// Move constructor
+	BigUnsigned(BigUnsigned &&x) noexcept : NumberlikeArray<Blk>(std::move(x)) {}
+
+	// Assignment operators
+	BigUnsigned &operator=(const BigUnsigned &x) {
 		NumberlikeArray<Blk>::operator =(x);
+		return *this;
+	}
+	BigUnsigned &operator=(BigUnsigned &&x) noexcept {
+		NumberlikeArray<Blk>::operator =(std::move(x));
+		return *this;
 	}
 
 	// Constructor that copies from a given array of blocks.
@@ -186,6 +194,22 @@ public:
 	void bitShiftLeft(const BigUnsigned &a, int b);
 	void bitShiftRight(const BigUnsigned &a, int b);
 
+	/* Operand sizes, in blocks, from which `multiply' switches from the
+	 * schoolbook method to Karatsuba's, from Karatsuba's to Toom-3, and
+	 * from Toom-3 to a number-theoretic transform (where the compiler has
+	 * 128-bit integers).  The size that counts is the smaller operand's.
+	 * They are public so that benchmarks can tune them. */
+	static Index karatsubaThreshold;
+	static Index toom3Threshold;
+	static Index nttThreshold;
+	/* Operand size, in blocks, from which the subproblems of `multiply'
+	 * (and of conversions between bases) are spread over the WorkerPool. */
+	static Index parallelThreshold;
+	/* Size, in blocks, from which `divideWithRemainder' divides
+	 * recursively rather than by Knuth's Algorithm D.  Both the divisor
+	 * and the quotient must be at least this long. */
+	static Index divisionThreshold;
+
 	/* `a.divideWithRemainder(b, q)' is like `q = a / b, a %= b'.
 	 * / and % use semantics similar to Knuth's, which differ from the
 	 * primitive integer semantics under division by zero.  See the
@@ -194,6 +218,22 @@ public:
 	 * sense to write quotient and remainder into the same variable. */
 	void divideWithRemainder(const BigUnsigned &b, BigUnsigned &q);
 
+protected:
+	/* Helpers for recursive division.  B is 2^N, the base of the blocks:
+	 * these are *this div B^k, *this mod B^k and *this * B^k. */
+	BigUnsigned blocksFrom(Index k) const;
+	BigUnsigned blocksBelow(Index k) const;
+	BigUnsigned blocksShifted(Index k) const;
+
+	/* `divideWithRemainder' for long divisors and quotients. */
+	void divideLong(const BigUnsigned &b, BigUnsigned &q);
+
+	/* Sets `q' and `r' to `a / b' and `a % b', where `b' has its top bit
+	 * set and `a' is at most twice as long as `b'. */
+	static void divideRecursive(const BigUnsigned &a, const BigUnsigned &b,
+			BigUnsigned &q, BigUnsigned &r);
+
+public:
 	/* `divide' and `modulo' are no longer offered.  Use
 	 * `divideWithRemainder' instead. */
 
@@ -231,10 +271,6 @@ public:
 	void operator --(   );
 	void operator --(int);
 
-	// Helper function that needs access to BigUnsigned internals
-	friend Blk getShiftedBlock(const BigUnsigned &num, Index x,
-			unsigned int y);
-
 	// See BigInteger.cc.
 	template <class X>
 	friend X convertBigUnsignedToPrimitiveAccess(const BigUnsigned &a);
@@ -357,9 +393,7 @@ void BigUnsigned::initFromPrimitive(X x) {
 	if (x == 0)
 		; // NumberlikeArray already initialized us to zero.
 	else {
-		// Create a single block.  blk is NULL; no need to delete it.
-		cap = 1;
-		blk = new Blk[1];
+		// Create a single block in the inline storage.
 		len = 1;
 		blk[0] = Blk(x);
 	}
@@ -1,4 +1,6 @@
 #include "BigUnsignedInABase.h"
+#include "WorkerPool.h"
+#include <vector>
 
 BigUnsignedInABase::BigUnsignedInABase(const Digit *d, Index l, Base base)
 	: NumberlikeArray<Digit>(d, l), base(base) {
@@ -16,17 +18,74 @@ BigUnsignedInABase::BigUnsignedInABase(const Digit *d, Index l, Base base)
 }
 
 namespace {
-	unsigned int bitLen(unsigned int x) {
-		unsigned int len = 0;
-		while (x > 0) {
-			x >>= 1;
-			len++;
-		}
-		return len;
-	}
 	unsigned int ceilingDiv(unsigned int a, unsigned int b) {
 		return (a + b - 1) / b;
 	}
+
+	typedef BigUnsigned::Blk Blk;
+	typedef BigUnsignedInABase::Digit Digit;
+	typedef BigUnsignedInABase::Base Base;
+
+	/*
+	 * Conversions handle digits in chunks: as many digits as fit in a
+	 * block (19 for base 10), so that within a chunk all the arithmetic is
+	 * on primitive integers.  `value' is base^digits.
+	 */
+	struct Chunk {
+		unsigned int digits;
+		Blk value;
+
+		Chunk(Base base) : digits(1), value(base) {
+			while (value <= Blk(-1) / base) {
+				value *= base;
+				digits++;
+			}
+		}
+	};
+
+	/* Numbers of at most this many blocks are split into chunks one short
+	 * division at a time, which beats dividing by a big power of the chunk
+	 * value. */
+	const unsigned int quadraticConversionLength = 24;
+
+	/*
+	 * Writes exactly `chunk.digits << (level + 1)' digits of `x', least
+	 * significant first and padded with zeros, to `out'.  `x' must be less
+	 * than powers[level]^2, where powers[i] is chunk.value^(2^i).
+	 *
+	 * This divides `x' by powers[level] and converts the quotient and
+	 * remainder independently, so that with fast division the whole
+	 * conversion costs about as much as a few multiplications of its size.
+	 * For huge numbers the two halves are converted in parallel.
+	 */
+	void writeDigits(const BigUnsigned &x, Digit *out, Base base, const Chunk &chunk,
+			const std::vector<BigUnsigned> &powers, unsigned int level) {
+		unsigned int width = chunk.digits << (level + 1), i, d;
+		if (x.isZero()) {
+			for (i = 0; i < width; i++)
+				out[i] = 0;
+			return;
+		}
+		if (powers[level].getLength() <= quadraticConversionLength) {
+			BigUnsigned rest(x), value, chunkValue(chunk.value);
+			for (i = 0; i < width; i += chunk.digits) {
+				// This is like `value = rest % chunkValue, rest /= chunkValue'.
+				value = rest;
+				value.divideWithRemainder(chunkValue, rest);
+				Blk v = value.getBlock(0);
+				for (d = 0; d < chunk.digits; d++) {
+					out[i + d] = Digit(v % base);
+					v /= base;
+				}
+			}
+			return;
+		}
+		BigUnsigned low(x), high;
+		low.divideWithRemainder(powers[level], high);
+		WorkerPool::run(powers[level].getLength() >= BigUnsigned::parallelThreshold,
+			[&] { writeDigits(low, out, base, chunk, powers, level - 1); },
+			[&] { writeDigits(high, out + width / 2, base, chunk, powers, level - 1); });
+	}
 }
 
 BigUnsignedInABase::BigUnsignedInABase(const BigUnsigned &x, Base base) {
@@ -34,40 +93,61 @@ BigUnsignedInABase::BigUnsignedInABase(const BigUnsigned &x, Base base) {
 	if (base < 2)
 		throw "BigUnsignedInABase(BigUnsigned, Base): The base must be at least 2";
 	this->base = base;
+	if (x.isZero())
+		return;
 
-	// Get an upper bound on how much space we need
-	int maxBitLenOfX = x.getLength() * BigUnsigned::N;
-	int minBitsPerDigit = bitLen(base) - 1;
-	int maxDigitLenOfX = ceilingDiv(maxBitLenOfX, minBitsPerDigit);
-	len = maxDigitLenOfX; // Another change to comply with `staying in bounds'.
-	allocate(len); // Get the space
+	/* Square the chunk value until its square certainly exceeds x: a number
+	 * of n blocks squares to at least 2n - 1 blocks. */
+	Chunk chunk(base);
+	std::vector<BigUnsigned> powers(1, BigUnsigned(chunk.value));
+	while (2 * powers.back().getLength() - 1 <= x.getLength())
+		powers.push_back(powers.back() * powers.back());
 
-	BigUnsigned x2(x), buBase(base);
-	Index digitNum = 0;
-
-	while (!x2.isZero()) {
-		// Get last digit.  This is like `lastDigit = x2 % buBase, x2 /= buBase'.
-		BigUnsigned lastDigit(x2);
-		lastDigit.divideWithRemainder(buBase, x2);
-		// Save the digit.
-		blk[digitNum] = lastDigit.toUnsignedShort();
-		// Move on.  We can't run out of room: we figured it out above.
-		digitNum++;
-	}
-
-	// Save the actual length.
-	len = digitNum;
+	len = chunk.digits << powers.size();
+	allocate(len); // Get the space
+	writeDigits(x, blk, base, chunk, powers, Index(powers.size() - 1));
+	zapLeadingZeros();
 }
 
+/*
+ * The reverse of `writeDigits', bottom-up: read each chunk of digits into a
+ * block, then repeatedly combine neighbors, the more significant one
+ * scaled by chunk.value^(2^i) on round i, until one number is left.  The
+ * pairs of a round are independent, so big rounds are shared out among
+ * the WorkerPool's threads.
+ */
 BigUnsignedInABase::operator BigUnsigned() const {
-	BigUnsigned ans(0), buBase(base), temp;
-	Index digitNum = len;
-	while (digitNum > 0) {
-		digitNum--;
-		temp.multiply(ans, buBase);
-		ans.add(temp, BigUnsigned(blk[digitNum]));
+	if (len == 0)
+		return BigUnsigned();
+	Chunk chunk(base);
+	Index chunks = ceilingDiv(len, chunk.digits), i, d;
+	std::vector<BigUnsigned> values(chunks);
+	for (i = 0; i < chunks; i++) {
+		Index end = (i + 1) * chunk.digits < len ? (i + 1) * chunk.digits : len;
+		Blk v = 0;
+		for (d = end; d > i * chunk.digits; d--)
+			v = v * base + blk[d - 1];
+		values[i] = BigUnsigned(v);
+	}
+	BigUnsigned power(chunk.value);
+	while (values.size() > 1) {
+		std::vector<BigUnsigned> combined((values.size() + 1) / 2);
+		auto combine = [&](Index begin, Index end) {
+			for (Index j = begin; j < end; j++)
+				combined[j] = (2 * j + 1 < values.size())
+					? values[2 * j] + values[2 * j + 1] * power
+					: values[2 * j];
+		};
+		Index n = Index(combined.size());
+		if (n * power.getLength() >= BigUnsigned::parallelThreshold)
+			WorkerPool::runRange(n, combine);
+		else
+			combine(0, n);
+		values.swap(combined);
+		if (values.size() > 1)
+			power = power * power;
 	}
-	return ans;
+	return values[0];
 }
 
 BigUnsignedInABase::BigUnsignedInABase(const std::string &s, Base base) {
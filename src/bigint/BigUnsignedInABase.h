@@ -57,10 +57,20 @@ public:
 	// Copy constructor
 	BigUnsignedInABase(const BigUnsignedInABase &x) : NumberlikeArray<Digit>(x), base(x.base) {}
 
-	// Assignment operator
-	void operator =(const BigUnsignedInABase &x) {
+	// Move constructor
+	BigUnsignedInABase(BigUnsignedInABase &&x) noexcept
+		: NumberlikeArray<Digit>(std::move(x)), base(x.base) {}
+
+	// Assignment operators
+	BigUnsignedInABase &operator =(const BigUnsignedInABase &x) {
 		NumberlikeArray<Digit>::operator =(x);
 		base = x.base;
+		return *this;
+	}
+	BigUnsignedInABase &operator =(BigUnsignedInABase &&x) noexcept {
+		NumberlikeArray<Digit>::operator =(std::move(x));
+		base = x.base;
+		return *this;
 	}
 
 	// Constructor that copies from a given array of digits.
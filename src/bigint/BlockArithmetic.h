@@ -0,0 +1,92 @@
+#ifndef BLOCKARITHMETIC_H
+#define BLOCKARITHMETIC_H
+
+#include "BigUnsigned.h"
+
+/* Arithmetic on single blocks, with double-block results or carries, for
+ * the library's own kernels that work a block at a time.  Not part of the
+ * interface. */
+
+typedef BigUnsigned::Blk Blk;
+
+static const unsigned int blockBits = 8 * sizeof(Blk);
+
+// Returns the low block of `a * b + c + d' and sets `high' to its high block.
+// The sum always fits in two blocks.
+static inline Blk multiplyAdd(Blk a, Blk b, Blk c, Blk d, Blk &high) {
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = (unsigned __int128)a * b + c + d;
+	high = Blk(p >> blockBits);
+	return Blk(p);
+#else
+	const unsigned int h = blockBits / 2;
+	const Blk mask = (Blk(1) << h) - 1;
+	Blk a0 = a & mask, a1 = a >> h, b0 = b & mask, b1 = b >> h;
+	Blk p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0;
+	Blk mid = (p00 >> h) + (p01 & mask) + (p10 & mask);
+	Blk low = (p00 & mask) | (mid << h);
+	high = a1 * b1 + (p01 >> h) + (p10 >> h) + (mid >> h);
+	low += c;
+	high += (low < c);
+	low += d;
+	high += (low < d);
+	return low;
+#endif
+}
+
+/* Add-with-carry and subtract-with-borrow, for chains of them along block
+ * arrays.  Where the compiler offers them these go through builtins or
+ * intrinsics that compile to the processor's own instructions (ADC and SBB
+ * on x86), rather than comparisons.  A `Carry' holds 0 or 1, in the type
+ * that lets the compiler keep it in the flags from one call to the next. */
+#ifdef __has_builtin
+#if __has_builtin(__builtin_addcl) && __has_builtin(__builtin_subcl)
+#define BLOCK_CARRY_BUILTINS
+#endif
+#endif
+#if !defined(BLOCK_CARRY_BUILTINS) && defined(__GNUC__) && defined(__x86_64__) && defined(__LP64__)
+#include <x86intrin.h>
+#define BLOCK_CARRY_INTRINSICS
+#endif
+
+#ifdef BLOCK_CARRY_INTRINSICS
+typedef unsigned char Carry;
+#else
+typedef Blk Carry;
+#endif
+
+// Returns the low block of `a + b + carry' and sets `carry' to the carry out.
+static inline Blk addCarry(Blk a, Blk b, Carry &carry) {
+#if defined(BLOCK_CARRY_BUILTINS)
+	return __builtin_addcl(a, b, carry, &carry);
+#elif defined(BLOCK_CARRY_INTRINSICS)
+	unsigned long long sum;
+	carry = _addcarry_u64(carry, a, b, &sum);
+	return Blk(sum);
+#else
+	Blk sum = a + carry;
+	Carry carryOut = (sum < carry);
+	sum += b;
+	carry = carryOut + (sum < b);
+	return sum;
+#endif
+}
+
+// Returns the low block of `a - b - borrow' and sets `borrow' to the borrow out.
+static inline Blk subtractBorrow(Blk a, Blk b, Carry &borrow) {
+#if defined(BLOCK_CARRY_BUILTINS)
+	return __builtin_subcl(a, b, borrow, &borrow);
+#elif defined(BLOCK_CARRY_INTRINSICS)
+	unsigned long long difference;
+	borrow = _subborrow_u64(borrow, a, b, &difference);
+	return Blk(difference);
+#else
+	Blk difference = a - borrow;
+	Carry borrowOut = (a < borrow);
+	borrow = borrowOut + (difference < b);
+	return difference - b;
+#endif
+}
+
+
+#endif
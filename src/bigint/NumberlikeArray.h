@@ -1,14 +1,21 @@
 #ifndef NUMBERLIKEARRAY_H
 #define NUMBERLIKEARRAY_H
 
+#include <utility>
+
 // Make sure we have NULL.
 #ifndef NULL
 #define NULL 0
 #endif
 
-/* A NumberlikeArray<Blk> object holds a heap-allocated array of Blk with a
- * length and a capacity and provides basic memory management features.
- * BigUnsigned and BigUnsignedInABase both subclass it.
+/* A NumberlikeArray<Blk> object holds an array of Blk with a length and a
+ * capacity and provides basic memory management features.  BigUnsigned and
+ * BigUnsignedInABase both subclass it.
+ *
+ * Arrays of up to `inlineCapacity' blocks (256 bits) live inside the object
+ * itself, so arithmetic on typical small numbers never touches the heap.
+ * Larger arrays are heap-allocated, and moving a NumberlikeArray hands its
+ * heap array over instead of copying it.
  *
  * NumberlikeArray provides no information hiding.  Subclasses should use
  * nonpublic inheritance and manually expose members as desired using
@@ -25,32 +32,35 @@ public:
 	typedef unsigned int Index;
 	// The number of bits in a block, defined below.
 	static const unsigned int N;
+	// The number of blocks that fit in the inline storage.
+	static const Index inlineCapacity = 32 / sizeof(Blk);
 
 	// The current allocated capacity of this NumberlikeArray (in blocks)
 	Index cap;
 	// The actual length of the value stored in this NumberlikeArray (in blocks)
 	Index len;
-	// Heap-allocated array of the blocks (can be NULL if len == 0)
+	// The array of the blocks: either `inlineBlk' or heap-allocated
 	Blk *blk;
+	// Storage for small arrays
+	Blk inlineBlk[inlineCapacity];
 
-	// Constructs a ``zero'' NumberlikeArray with the given capacity.
-	NumberlikeArray(Index c) : cap(c), len(0) { 
-		blk = (cap > 0) ? (new Blk[cap]) : NULL;
+	// Constructs a ``zero'' NumberlikeArray with at least the given capacity.
+	NumberlikeArray(Index c) : cap(inlineCapacity), len(0), blk(inlineBlk) { 
+		allocate(c);
 	}
 
-	/* Constructs a zero NumberlikeArray without allocating a backing array.
-	 * A subclass that doesn't know the needed capacity at initialization
-	 * time can use this constructor and then overwrite blk without first
-	 * deleting it. */
-	NumberlikeArray() : cap(0), len(0) {
-		blk = NULL;
-	}
+	// Constructs a zero NumberlikeArray that uses the inline storage.
+	NumberlikeArray() : cap(inlineCapacity), len(0), blk(inlineBlk) {}
 
-	// Destructor.  Note that `delete NULL' is a no-op.
+	// Destructor.
 	~NumberlikeArray() {
-		delete [] blk;
+		if (!isInline())
+			delete [] blk;
 	}
 
+	// Whether the blocks are in the inline storage.
+	bool isInline() const { return blk == inlineBlk; }
+
 	/* Ensures that the array has at least the requested capacity; may
 	 * destroy the contents. */
 	void allocate(Index c);
@@ -63,7 +73,12 @@ public:
 	NumberlikeArray(const NumberlikeArray<Blk> &x);
 
 	// Assignment operator
-	void operator=(const NumberlikeArray<Blk> &x);
+	NumberlikeArray<Blk> &operator=(const NumberlikeArray<Blk> &x);
+
+	/* Move constructor and assignment.  A heap array is taken over, and `x'
+	 * is left as zero in its inline storage. */
+	NumberlikeArray(NumberlikeArray<Blk> &&x) noexcept;
+	NumberlikeArray<Blk> &operator=(NumberlikeArray<Blk> &&x) noexcept;
 
 	// Constructor that copies from a given array of blocks
 	NumberlikeArray(const Blk *b, Index blen);
@@ -95,7 +110,8 @@ void NumberlikeArray<Blk>::allocate(Index c) {
 	// If the requested capacity is more than the current capacity...
 	if (c > cap) {
 		// Delete the old number array
-		delete [] blk;
+		if (!isInline())
+			delete [] blk;
 		// Allocate the new array
 		cap = c;
 		blk = new Blk[cap];
@@ -115,16 +131,16 @@ void NumberlikeArray<Blk>::allocateAndCopy(Index c) {
 		for (i = 0; i < len; i++)
 			blk[i] = oldBlk[i];
 		// Delete the old array
-		delete [] oldBlk;
+		if (oldBlk != inlineBlk)
+			delete [] oldBlk;
 	}
 }
 
 template <class Blk>
 NumberlikeArray<Blk>::NumberlikeArray(const NumberlikeArray<Blk> &x)
-		: len(x.len) {
+		: cap(inlineCapacity), len(x.len), blk(inlineBlk) {
 	// Create array
-	cap = len;
-	blk = new Blk[cap];
+	allocate(len);
 	// Copy blocks
 	Index i;
 	for (i = 0; i < len; i++)
@@ -132,11 +148,11 @@ NumberlikeArray<Blk>::NumberlikeArray(const NumberlikeArray<Blk> &x)
 }
 
 template <class Blk>
-void NumberlikeArray<Blk>::operator=(const NumberlikeArray<Blk> &x) {
+NumberlikeArray<Blk> &NumberlikeArray<Blk>::operator=(const NumberlikeArray<Blk> &x) {
 	/* Calls like a = a have no effect; catch them before the aliasing
 	 * causes a problem */
 	if (this == &x)
-		return;
+		return *this;
 	// Copy length
 	len = x.len;
 	// Expand array if necessary
@@ -145,13 +161,54 @@ void NumberlikeArray<Blk>::operator=(const NumberlikeArray<Blk> &x) {
 	Index i;
 	for (i = 0; i < len; i++)
 		blk[i] = x.blk[i];
+	return *this;
+}
+
+template <class Blk>
+NumberlikeArray<Blk>::NumberlikeArray(NumberlikeArray<Blk> &&x) noexcept
+		: cap(inlineCapacity), len(x.len), blk(inlineBlk) {
+	if (x.isInline()) {
+		Index i;
+		for (i = 0; i < len; i++)
+			blk[i] = x.blk[i];
+	} else {
+		cap = x.cap;
+		blk = x.blk;
+		x.cap = inlineCapacity;
+		x.blk = x.inlineBlk;
+	}
+	x.len = 0;
+}
+
+template <class Blk>
+NumberlikeArray<Blk> &NumberlikeArray<Blk>::operator=(NumberlikeArray<Blk> &&x) noexcept {
+	if (this == &x)
+		return *this;
+	if (x.isInline()) {
+		/* The blocks fit in our inline storage, or in the heap array we
+		 * already have. */
+		len = x.len;
+		Index i;
+		for (i = 0; i < len; i++)
+			blk[i] = x.blk[i];
+	} else {
+		if (!isInline())
+			delete [] blk;
+		cap = x.cap;
+		len = x.len;
+		blk = x.blk;
+		x.cap = inlineCapacity;
+		x.blk = x.inlineBlk;
+	}
+	x.len = 0;
+	return *this;
 }
 
 template <class Blk>
 NumberlikeArray<Blk>::NumberlikeArray(const Blk *b, Index blen)
-		: cap(blen), len(blen) {
+		: cap(inlineCapacity), len(blen), blk(inlineBlk) {
 	// Create array
-	blk = new Blk[cap];
+	allocate(len);
 	// Copy blocks
 	Index i;
 	for (i = 0; i < len; i++)
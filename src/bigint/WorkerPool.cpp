@@ -0,0 +1,157 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace {
+	struct Task {
+		const std::function<void()> *work;
+		std::exception_ptr error;
+		bool done;
+
+		Task(const std::function<void()> &work) : work(&work), done(false) {}
+
+		void run() {
+			try {
+				(*work)();
+			} catch (...) {
+				error = std::current_exception();
+			}
+		}
+	};
+
+	struct Pool {
+		std::mutex lock;
+		// Signals the workers that a task was queued
+		std::condition_variable queued;
+		// Signals the forking threads that a task is done
+		std::condition_variable finished;
+		std::deque<Task *> queue;
+		unsigned int maxThreads;
+		// Workers started, and those with a task, queued or running
+		unsigned int workers, busy;
+
+		Pool() : maxThreads(std::thread::hardware_concurrency()), workers(0), busy(0) {
+			if (maxThreads == 0)
+				maxThreads = 1;
+		}
+	};
+
+	/* The workers are detached and may still be waiting on the pool when
+	 * the program exits, so it is never destroyed. */
+	Pool &pool() {
+		static Pool *p = new Pool;
+		return *p;
+	}
+
+	void work(Pool &p) {
+		std::unique_lock<std::mutex> guard(p.lock);
+		for (;;) {
+			p.queued.wait(guard, [&p] { return !p.queue.empty(); });
+			Task *task = p.queue.front();
+			p.queue.pop_front();
+			guard.unlock();
+			task->run();
+			guard.lock();
+			task->done = true;
+			p.busy--;
+			p.finished.notify_all();
+		}
+	}
+
+	/* Hands `first' to an idle worker, if the cap allows, and runs `second'
+	 * meanwhile.  A worker never waits for another's task, so there are
+	 * exactly `workers - busy' idle ones. */
+	void runBoth(const std::function<void()> &first, const std::function<void()> &second) {
+		Pool &p = pool();
+		Task task(first);
+		{
+			std::lock_guard<std::mutex> guard(p.lock);
+			if (p.busy + 1 >= p.maxThreads) {
+				// Run both here, after dropping the lock.
+				task.work = NULL;
+			} else {
+				if (p.busy == p.workers) {
+					std::thread(work, std::ref(p)).detach();
+					p.workers++;
+				}
+				p.busy++;
+				p.queue.push_back(&task);
+			}
+		}
+		if (task.work == NULL) {
+			first();
+			second();
+			return;
+		}
+		p.queued.notify_one();
+
+		std::exception_ptr error;
+		try {
+			second();
+		} catch (...) {
+			error = std::current_exception();
+		}
+		// `task' lives on this stack, so wait for it even after an exception.
+		std::unique_lock<std::mutex> guard(p.lock);
+		std::deque<Task *>::iterator it = std::find(p.queue.begin(), p.queue.end(), &task);
+		if (it != p.queue.end()) {
+			// No worker got to it yet: take it back.
+			p.queue.erase(it);
+			p.busy--;
+			guard.unlock();
+			task.run();
+		} else
+			p.finished.wait(guard, [&task] { return task.done; });
+		if (task.error)
+			std::rethrow_exception(task.error);
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	void runTasks(const std::function<void()> *tasks, size_t n) {
+		if (n == 1)
+			(*tasks)();
+		else if (n > 1) {
+			size_t half = n / 2;
+			runBoth([=] { runTasks(tasks, half); }, [=] { runTasks(tasks + half, n - half); });
+		}
+	}
+
+	void runRanges(unsigned int begin, unsigned int end, unsigned int pieces,
+			const std::function<void(unsigned int, unsigned int)> &body) {
+		if (pieces <= 1) {
+			body(begin, end);
+			return;
+		}
+		unsigned int half = pieces / 2;
+		unsigned int middle = begin + (unsigned int)((unsigned long long)(end - begin) * half / pieces);
+		runBoth([&] { runRanges(begin, middle, half, body); },
+			[&] { runRanges(middle, end, pieces - half, body); });
+	}
+}
+
+unsigned int WorkerPool::getMaxThreads() {
+	Pool &p = pool();
+	std::lock_guard<std::mutex> guard(p.lock);
+	return p.maxThreads;
+}
+
+void WorkerPool::setMaxThreads(unsigned int n) {
+	Pool &p = pool();
+	std::lock_guard<std::mutex> guard(p.lock);
+	p.maxThreads = (n == 0) ? 1 : n;
+}
+
+void WorkerPool::runAll(std::initializer_list<std::function<void()> > tasks) {
+	runTasks(tasks.begin(), tasks.size());
+}
+
+void WorkerPool::runRange(unsigned int n,
+		const std::function<void(unsigned int, unsigned int)> &body) {
+	unsigned int pieces = getMaxThreads();
+	runRanges(0, n, (pieces < n) ? pieces : n, body);
+}
@@ -0,0 +1,44 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <functional>
+#include <initializer_list>
+
+/*
+ * A bounded pool of worker threads, onto which the algorithms for huge
+ * numbers fork independent subproblems.  At most `getMaxThreads()' threads,
+ * counting the ones that fork, compute at once.  A fork made while every
+ * worker is busy simply runs on the calling thread, so nested forks never
+ * wait for a thread to come free.
+ *
+ * The workers are started on first use and then sleep until needed.
+ */
+class WorkerPool {
+public:
+	/* The cap on threads at work.  It starts at the number of hardware
+	 * threads; 1 keeps all the work on the calling thread.  There is one
+	 * pool per process, so the cap applies to every thread that forks. */
+	static unsigned int getMaxThreads();
+	static void setMaxThreads(unsigned int n);
+
+	/* Runs the tasks, possibly at the same time, and returns once all have
+	 * finished.  If any throws, one of the exceptions is rethrown then. */
+	static void runAll(std::initializer_list<std::function<void()> > tasks);
+
+	/* Calls `body(begin, end)' on consecutive ranges covering [0, n), one
+	 * per thread available, through `runAll'. */
+	static void runRange(unsigned int n,
+			const std::function<void(unsigned int, unsigned int)> &body);
+
+	/* Runs the tasks through `runAll' if `parallel', else one after
+	 * another, without the cost of wrapping them in std::functions. */
+	template <class... Tasks>
+	static void run(bool parallel, Tasks... tasks) {
+		if (parallel)
+			runAll({ std::function<void()>(tasks)... });
+		else
+			(tasks(), ...);
+	}
+};
+
+#endif
@@ -39,9 +39,28 @@
 
 using namespace std;
 
-int main(int, char**) {
+int main(int argc, char** argv) {
+  auto engine = CommandLine::Tree;
+  unsigned threads = 0;
+  static const boost::regex threads_regex("--threads=([0-9]{1,4})");
+  for (int i = 1; i < argc; ++i) {
+    string option(argv[i]);
+    boost::smatch sm;
+    if (option == "--engine=tree") {
+      engine = CommandLine::Tree;
+    } else if (option == "--engine=vm") {
+      engine = CommandLine::VM;
+    } else if (option == "--engine=closure") {
+      engine = CommandLine::Closure;
+    } else if (boost::regex_match(option, sm, threads_regex)) {
+      threads = stoul(sm[1].str());
+    } else {
+      cerr << "usage: " << argv[0] << " [--engine=tree|vm|closure] [--threads=N]" << endl;
+      return 1;
+    }
+  }
 
-  CommandLine cm;
+  CommandLine cm(engine, threads);
   cm.respond(">> ");
 
   cin.get();